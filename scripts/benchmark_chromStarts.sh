@@ -0,0 +1,104 @@
+#!/bin/bash
+
+usage() {
+  cat >&2 <<__EOF__
+Usage:  "$0" [options] OLD_HOTSPOT2_PART1 NEW_HOTSPOT2_PART1
+
+Times two hotspot2_part1 executables on synthetic input that consists mostly of
+window starts (new chromosomes, and islands of sites separated by gaps wider than
+half the background window), where the whole left half of the window is handed
+P-values at once.  Output from the two executables is compared as well.
+
+Options:
+    -h                 Show this helpful help
+
+    -c NUM_CHROMS      Number of chromosomes                       (200)
+    -i NUM_ISLANDS     Islands of contiguous sites per chromosome  (20)
+    -b BACKGROUND      Background window size passed to both       (50001)
+    -r REPS            Timed repetitions per executable            (3)
+__EOF__
+  exit 2
+}
+
+NUM_CHROMS=200
+NUM_ISLANDS=20
+BACKGROUND_WINDOW_SIZE=50001
+REPS=3
+
+AWK_EXE=$(which mawk 2>/dev/null || which awk)
+
+while getopts 'hc:i:b:r:' opt; do
+  case "$opt" in
+    h) usage ;;
+    c) NUM_CHROMS=$OPTARG ;;
+    i) NUM_ISLANDS=$OPTARG ;;
+    b) BACKGROUND_WINDOW_SIZE=$OPTARG ;;
+    r) REPS=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+
+shift $((OPTIND - 1))
+
+if [[ $# -lt 2 ]]; then
+  usage
+fi
+
+OLD_EXE=$1
+NEW_EXE=$2
+
+TMPDIR=${TMPDIR:-/tmp}
+workdir=$(mktemp -d "$TMPDIR/benchmark_chromStarts.XXXXXX")
+trap 'rm -rf "$workdir"' EXIT
+
+# Each island is as wide as the window, so every site in its left half
+# is assigned a P-value when the window first fills.
+# srand() is seeded so that runs are reproducible.
+"$AWK_EXE" -v nchroms="$NUM_CHROMS" -v nislands="$NUM_ISLANDS" -v w="$BACKGROUND_WINDOW_SIZE" '
+  BEGIN {
+    srand(12345)
+    for (c = 1; c <= nchroms; c++) {
+      pos = 10000
+      for (i = 0; i < nislands; i++) {
+        for (j = 0; j < w; j++) {
+          printf "chr%d\t%d\t%d\ti\t%d\n", c, pos, pos + 1, int(-log(1 - rand()) * 3)
+          pos++
+        }
+        pos += w
+      }
+    }
+  }' > "$workdir/in.bed"
+
+echo "Input:  $(wc -l < "$workdir/in.bed") sites on $NUM_CHROMS chromosomes, $NUM_ISLANDS islands each"
+
+time_it() {
+  local exe=$1
+  local tag=$2
+  local best=
+  local r
+  for ((r = 0; r < REPS; r++)); do
+    local t0 t1 secs
+    t0=$(date +%s.%N)
+    "$exe" -b "$BACKGROUND_WINDOW_SIZE" -i "$workdir/in.bed" \
+      -o "$workdir/$tag.out" -c "$workdir/$tag.chr" -p "$workdir/$tag.pv" \
+      || { echo "$exe failed" >&2; exit 1; }
+    t1=$(date +%s.%N)
+    best=$("$AWK_EXE" -v t0="$t0" -v t1="$t1" -v best="$best" \
+      'BEGIN { s = t1 - t0; if (best == "" || s < best) best = s; printf "%.3f", best }')
+  done
+  echo "$best"
+}
+
+old_secs=$(time_it "$OLD_EXE" old)
+new_secs=$(time_it "$NEW_EXE" new)
+
+printf "%-8s %10s s  (best of %d)\n" old "$old_secs" "$REPS"
+printf "%-8s %10s s  (best of %d)\n" new "$new_secs" "$REPS"
+"$AWK_EXE" -v o="$old_secs" -v n="$new_secs" 'BEGIN { printf "speedup  %.2fx\n", o / n }'
+
+if cmp -s "$workdir/old.out" "$workdir/new.out" && cmp -s "$workdir/old.pv" "$workdir/new.pv"; then
+  echo "Outputs are identical."
+else
+  echo "Outputs differ!" >&2
+  exit 1
+fi
@@ -0,0 +1,156 @@
+#!/bin/bash
+
+usage() {
+  cat >&2 <<__EOF__
+Usage:  "$0" [options] OLD_BINDIR NEW_BINDIR
+
+Times the text-reading tools in two directories of hotspot2 executables
+(hotspot2_bed2bin, hotspot2_part1, hotspot2_part2, findVarWidthPeaks,
+resolveOverlapsInSummit-CenteredPeaks) on synthetic input, and reports
+lines of input per second for each.  hotspot2_bed2bin does little besides
+parsing, so it shows the cost of reading hotspot2_part1's input most directly.
+Output from the two versions of each tool is compared as well.
+
+Options:
+    -h                 Show this helpful help
+
+    -l NUM_LINES       Approximate number of lines of input per tool  (2000000)
+    -r REPS            Timed repetitions per executable              (3)
+__EOF__
+  exit 2
+}
+
+NUM_LINES=2000000
+REPS=3
+
+AWK_EXE=$(which mawk 2>/dev/null || which awk)
+
+while getopts 'hl:r:' opt; do
+  case "$opt" in
+    h) usage ;;
+    l) NUM_LINES=$OPTARG ;;
+    r) REPS=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+
+shift $((OPTIND - 1))
+
+if [[ $# -lt 2 ]]; then
+  usage
+fi
+
+OLD_BINDIR=$1
+NEW_BINDIR=$2
+
+TMPDIR=${TMPDIR:-/tmp}
+workdir=$(mktemp -d "$TMPDIR/benchmark_parsing.XXXXXX")
+trap 'rm -rf "$workdir"' EXIT
+
+# srand() is seeded so that runs are reproducible.
+
+# Cut counts (BED5), on 4 chromosomes, with runs of equal counts in places.
+"$AWK_EXE" -v n="$NUM_LINES" '
+  BEGIN {
+    srand(12345)
+    per = int(n / 4)
+    for (c = 1; c <= 4; c++) {
+      pos = 10000
+      for (i = 0; i < per; i++) {
+        w = (rand() < 0.2) ? 1 + int(rand() * 20) : 1
+        printf "chr%d\t%d\t%d\ti\t%d\n", c, pos, pos + w, int(-log(1 - rand()) * 4)
+        pos += w
+      }
+    }
+  }' > "$workdir/cutcounts.bed"
+
+# Input for findVarWidthPeaks:  1 bp sites around summits, with a smooth profile of scores.
+"$AWK_EXE" -v n="$NUM_LINES" '
+  BEGIN {
+    srand(12345)
+    pos = 1000
+    for (i = 0; i < n; ) {
+      pos += 160 + int(rand() * 400)
+      w = 20 + int(rand() * 55)
+      for (x = pos - w; x <= pos + w; x++) {
+        d = (x - pos) / 25
+        printf "chr1\t%d\t%d\tid\t%.4f\t%d\n", x - 1, x, 10 * exp(-d * d) + rand(), pos
+        i++
+      }
+    }
+  }' > "$workdir/density.txt"
+
+# Input for resolveOverlapsInSummit-CenteredPeaks:  merged peaks, "|", then the overlapping peaks.
+"$AWK_EXE" -v n="$NUM_LINES" '
+  BEGIN {
+    srand(12345)
+    pos = 1000
+    for (i = 0; i < n; i++) {
+      pos += 200 + int(rand() * 1800)
+      k = 1 + int(rand() * 5)
+      lo = -1; hi = -1; s = ""
+      for (j = 0; j < k; j++) {
+        b = pos + int(rand() * 300)
+        e = b + 50 + int(rand() * 250)
+        if (lo == -1 || b < lo) lo = b
+        if (e > hi) hi = e
+        s = s (j ? ";" : "") sprintf("chr1\t%d\t%d\tid%d\t%.6g", b, e, j, rand() * 100)
+      }
+      printf "chr1\t%d\t%d|%s\n", lo, hi, s
+      pos = hi
+    }
+  }' > "$workdir/overlaps.txt"
+
+# Input for hotspot2_part2 is hotspot2_part1's output.
+"$NEW_BINDIR/hotspot2_part1" -i "$workdir/cutcounts.bed" -o "$workdir/pvals.txt" \
+  -c "$workdir/pvals.chr" -p "$workdir/pvals.hist" \
+  || { echo "$NEW_BINDIR/hotspot2_part1 failed" >&2; exit 1; }
+
+# time_it TAG INPUT_FILE COMMAND...:  prints the best time in seconds; stdout goes to $workdir/TAG.out
+time_it() {
+  local tag=$1
+  local input=$2
+  shift 2
+  local best=
+  local r
+  for ((r = 0; r < REPS; r++)); do
+    local t0 t1
+    t0=$(date +%s.%N)
+    "$@" < "$input" > "$workdir/$tag.out" || { echo "$1 failed" >&2; exit 1; }
+    t1=$(date +%s.%N)
+    best=$("$AWK_EXE" -v t0="$t0" -v t1="$t1" -v best="$best" \
+      'BEGIN { s = t1 - t0; if (best == "" || s < best) best = s; printf "%.3f", best }')
+  done
+  echo "$best"
+}
+
+status=0
+printf "%-38s %10s %10s %14s %14s %8s\n" tool "old (s)" "new (s)" "old lines/s" "new lines/s" speedup
+
+# bench NAME INPUT_FILE ARGS...
+bench() {
+  local name=$1
+  local input=$2
+  shift 2
+  local nlines old_secs new_secs
+  nlines=$(wc -l < "$input")
+  old_secs=$(time_it old "$input" "$OLD_BINDIR/$name" "$@")
+  new_secs=$(time_it new "$input" "$NEW_BINDIR/$name" "$@")
+  "$AWK_EXE" -v name="$name" -v o="$old_secs" -v n="$new_secs" -v l="$nlines" \
+    'BEGIN { printf "%-38s %10.3f %10.3f %14.0f %14.0f %7.2fx\n", name, o, n, l / o, l / n, o / n }'
+  if ! cmp -s "$workdir/old.out" "$workdir/new.out"; then
+    echo "Outputs of $name differ!" >&2
+    status=1
+  fi
+}
+
+bench hotspot2_bed2bin "$workdir/cutcounts.bed"
+bench hotspot2_part1 "$workdir/cutcounts.bed" -c "$workdir/part1.chr" -p "$workdir/part1.hist"
+bench hotspot2_part2 "$workdir/pvals.txt" -c "$workdir/pvals.chr" -p "$workdir/pvals.hist"
+bench findVarWidthPeaks "$workdir/density.txt" 20
+bench resolveOverlapsInSummit-CenteredPeaks "$workdir/overlaps.txt"
+
+if [[ $status -eq 0 ]]; then
+  echo "Outputs are identical."
+fi
+exit $status
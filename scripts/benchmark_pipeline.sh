@@ -0,0 +1,229 @@
+#!/bin/bash
+
+usage() {
+  cat >&2 <<__EOF__
+Usage:  "$0" [options] BINDIR
+
+Runs hotspot2_part1, hotspot2_part2 and findVarWidthPeaks from BINDIR in turn on synthetic data
+(see scripts/synthetic_cutcounts.sh), and reports for each stage the number of sites it read,
+its wall time, its throughput in sites per second, and its peak resident set size,
+as tab-separated columns following a "#" line that describes the workload.
+findVarWidthPeaks gets the tallies within the hotspots found by hotspot2_part2,
+with each hotspot's highest tally as its summit; preparing that input isn't timed.
+BINDIR must also contain hotspot2_measure, which "make bench" builds.
+
+When a baseline (the output of an earlier run, on the same workload) is given,
+each stage is compared with it, and the run fails if any stage's throughput has fallen,
+or its peak RSS has risen, by more than the allowed percentage.
+
+Options:
+    -h                 Show this helpful help
+
+    -c NUM_CHROMS      Number of chromosomes of synthetic data              (4)
+    -l LENGTH          Length of each chromosome, in bp                     (500000)
+    -d DEPTH           Mean tally outside hotspots                          (30)
+    -f FDR             FDR threshold for hotspot2_part2                     (0.05)
+    -t THREADS         Threads for hotspot2_part1                           (1)
+    -r REPS            Timed repetitions per stage; the fastest is reported (3)
+    -m MIN_SECONDS     Within a repetition, rerun a stage until it has run
+                       this long in all, and time it per run                (1)
+    -w WORKDIR         Keep the synthetic data, outputs, and results (results.tsv)
+                       here, and reuse data generated with the same settings (a temporary directory)
+    -o FILE            Also write the results to FILE
+    -b BASELINE        Compare the results with those in BASELINE
+    -x PERCENT         Largest change allowed relative to the baseline      (10)
+__EOF__
+  exit 2
+}
+
+NUM_CHROMS=4
+LENGTH=500000
+DEPTH=30
+FDR=0.05
+THREADS=1
+REPS=3
+MIN_SECONDS=1
+WORKDIR=
+RESULTS_FILE=
+BASELINE=
+MAX_CHANGE_PCT=10
+
+AWK_EXE=$(which mawk 2>/dev/null || which awk)
+
+while getopts 'hc:l:d:f:t:r:m:w:o:b:x:' opt; do
+  case "$opt" in
+    h) usage ;;
+    c) NUM_CHROMS=$OPTARG ;;
+    l) LENGTH=$OPTARG ;;
+    d) DEPTH=$OPTARG ;;
+    f) FDR=$OPTARG ;;
+    t) THREADS=$OPTARG ;;
+    r) REPS=$OPTARG ;;
+    m) MIN_SECONDS=$OPTARG ;;
+    w) WORKDIR=$OPTARG ;;
+    o) RESULTS_FILE=$OPTARG ;;
+    b) BASELINE=$OPTARG ;;
+    x) MAX_CHANGE_PCT=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+
+shift $((OPTIND - 1))
+
+if [[ $# -ne 1 ]]; then
+  usage
+fi
+
+BINDIR=$1
+for exe in hotspot2_part1 hotspot2_part2 findVarWidthPeaks hotspot2_measure; do
+  if [[ ! -x "$BINDIR/$exe" ]]; then
+    echo "Error:  $BINDIR/$exe was not found, or is not executable." >&2
+    exit 2
+  fi
+done
+
+if [[ -z "$WORKDIR" ]]; then
+  TMPDIR=${TMPDIR:-/tmp}
+  WORKDIR=$(mktemp -d "$TMPDIR/benchmark_pipeline.XXXXXX")
+  trap 'rm -rf "$WORKDIR"' EXIT
+else
+  mkdir -p "$WORKDIR" || exit 2
+fi
+
+workload="-c $NUM_CHROMS -l $LENGTH -d $DEPTH -f $FDR -t $THREADS"
+data="$WORKDIR/tallies.c$NUM_CHROMS.l$LENGTH.d$DEPTH.bed"
+if [[ ! -s "$data" ]]; then
+  echo "Generating synthetic data ($data)..." >&2
+  "$(dirname "$0")/synthetic_cutcounts.sh" -c "$NUM_CHROMS" -l "$LENGTH" -d "$DEPTH" > "$data.tmp" \
+    && mv "$data.tmp" "$data" \
+    || { echo "Error:  Failed to generate synthetic data." >&2; exit 2; }
+fi
+
+results="$WORKDIR/results.tsv"
+{
+  echo "# workload: $workload"
+  printf "stage\tsites\twall_seconds\tsites_per_second\tmax_rss_kib\n"
+} > "$results"
+
+# run_stage STAGE INPUT_FILE OUTPUT_FILE COMMAND...:  runs the command, with stdin and stdout redirected,
+# REPS times (each of them as many times as it takes to fill MIN_SECONDS, so that fast stages can be timed reliably),
+# and appends the fastest time per run and the largest peak RSS to the results
+run_stage() {
+  local stage=$1
+  local input=$2
+  local output=$3
+  shift 3
+  local best= rss=0
+  local r total runs secs kib status
+  for ((r = 0; r < REPS; r++)); do
+    total=0
+    runs=0
+    while [[ $runs -eq 0 ]] || "$AWK_EXE" -v t="$total" -v m="$MIN_SECONDS" 'BEGIN { exit !(t < m) }'; do
+      "$BINDIR/hotspot2_measure" -o "$WORKDIR/$stage.measured" "$@" < "$input" > "$output" 2> "$WORKDIR/$stage.err"
+      read -r secs kib status < "$WORKDIR/$stage.measured"
+      if [[ "$status" != "0" ]]; then
+        echo "Error:  $stage failed (exit status $status); see $WORKDIR/$stage.err." >&2
+        exit 2
+      fi
+      total=$("$AWK_EXE" -v t="$total" -v s="$secs" 'BEGIN { printf "%.3f", t + s }')
+      runs=$((runs + 1))
+      if [[ $kib -gt $rss ]]; then
+        rss=$kib
+      fi
+    done
+    best=$("$AWK_EXE" -v t="$total" -v n="$runs" -v best="$best" 'BEGIN { s = t / n; if (best == "" || s < best) best = s; printf "%.4f", best }')
+  done
+  "$AWK_EXE" -v stage="$stage" -v n="$(wc -l < "$input")" -v s="$best" -v rss="$rss" \
+    'BEGIN { printf "%s\t%d\t%.4f\t%.0f\t%d\n", stage, n, s, (s > 0 ? n / s : 0), rss }' >> "$results"
+}
+
+echo "Running hotspot2_part1..." >&2
+run_stage hotspot2_part1 "$data" "$WORKDIR/pvals.txt" \
+  "$BINDIR/hotspot2_part1" -t "$THREADS" -i "$data" -c "$WORKDIR/pvals.chr" -p "$WORKDIR/pvals.hist"
+
+echo "Running hotspot2_part2..." >&2
+run_stage hotspot2_part2 "$WORKDIR/pvals.txt" "$WORKDIR/sites.fdr.bed" \
+  "$BINDIR/hotspot2_part2" -f "$FDR" -c "$WORKDIR/pvals.chr" -p "$WORKDIR/pvals.hist"
+
+# Merge the significant sites into hotspots, then list the tallies within each one, with its summit.
+# Both files are in the same (input) order.
+"$AWK_EXE" 'BEGIN { OFS = "\t" }
+  {
+    if ($1 == chr && $2 <= end + 100) {
+      if ($3 > end) end = $3
+      next
+    }
+    if (chr != "") print chr, beg, end
+    chr = $1; beg = $2; end = $3
+  }
+  END { if (chr != "") print chr, beg, end }' "$WORKDIR/sites.fdr.bed" > "$WORKDIR/hotspots.bed"
+"$AWK_EXE" 'BEGIN { OFS = "\t" }
+  function flush(    j) {
+    for (j = 1; j <= m; j++)
+      print hc[i], xs[j], xs[j] + 1, "id", ys[j], summit
+    m = 0; maxY = -1
+  }
+  NR == FNR { n++; hc[n] = $1; hb[n] = $2; he[n] = $3; next }
+  FNR == 1 { i = 1; m = 0; maxY = -1 }
+  {
+    if ($1 != prevChr) {
+      done[prevChr] = 1
+      prevChr = $1
+    }
+    while (i <= n && ((hc[i] == $1 && he[i] <= $2) || (hc[i] != $1 && (hc[i] in done)))) {
+      flush()
+      i++
+    }
+    if (i <= n && hc[i] == $1 && $2 >= hb[i]) {
+      xs[++m] = $2; ys[m] = $5
+      if ($5 > maxY) { maxY = $5; summit = $2 + 1 }
+    }
+  }
+  END { if (i <= n) flush() }' "$WORKDIR/hotspots.bed" "$data" > "$WORKDIR/density.txt"
+
+echo "Running findVarWidthPeaks..." >&2
+run_stage findVarWidthPeaks "$WORKDIR/density.txt" "$WORKDIR/peaks.bed" \
+  "$BINDIR/findVarWidthPeaks" 20
+
+cat "$results"
+if [[ -n "$RESULTS_FILE" && ! "$RESULTS_FILE" -ef "$results" ]]; then
+  cp "$results" "$RESULTS_FILE" || exit 2
+fi
+
+if [[ -z "$BASELINE" ]]; then
+  exit 0
+fi
+if [[ ! -s "$BASELINE" ]]; then
+  echo "No baseline was found at $BASELINE, so none was compared." >&2
+  exit 0
+fi
+if [[ "$(head -n 1 "$BASELINE")" != "# workload: $workload" ]]; then
+  echo "Error:  The baseline in $BASELINE was measured on a different workload:" >&2
+  echo "  $(head -n 1 "$BASELINE")" >&2
+  exit 2
+fi
+
+echo >&2
+"$AWK_EXE" -F "\t" -v pct="$MAX_CHANGE_PCT" '
+  FNR <= 2 { next }
+  NR == FNR { basePerSec[$1] = $4; baseRss[$1] = $5; next }
+  {
+    if (!($1 in basePerSec)) {
+      printf "%-22s  not in the baseline\n", $1
+      next
+    }
+    dSpeed = (basePerSec[$1] > 0) ? 100 * ($4 - basePerSec[$1]) / basePerSec[$1] : 0
+    dRss = (baseRss[$1] > 0) ? 100 * ($5 - baseRss[$1]) / baseRss[$1] : 0
+    flag = ""
+    if (dSpeed < -pct) flag = flag "  REGRESSION (throughput)"
+    if (dRss > pct) flag = flag "  REGRESSION (peak RSS)"
+    if (flag != "") status = 1
+    printf "%-22s  sites/s %+7.1f%%   peak RSS %+7.1f%%%s\n", $1, dSpeed, dRss, flag
+  }
+  END {
+    if (status)
+      printf "Regressions of more than %s%% relative to the baseline were found.\n", pct
+    else
+      printf "No stage changed by more than %s%% for the worse relative to the baseline.\n", pct
+    exit status
+  }' "$BASELINE" "$results" >&2
@@ -61,6 +61,9 @@ Options:
                           a local minimum is substituted whenever half-maximum is not attained.
                           These variable-width peaks are guided by wavelet summits
                           (each contains one, or the summit of the max density when absent).
+    -2                    Run hotspot2_part1 and hotspot2_part2 as two separate steps, instead of
+                          hotspot2_engine.  Part 1's output is kept in \$TMPDIR, if it was set,
+                          so that a rerun after a failure in part 2 skips part 1.
 
 
     Neighborhood and window sizes are specified as the distance from the edge
@@ -103,10 +106,11 @@ PEAK_TYPE="default_peaks"
 VAR_WIDTH_PEAKS="0"
 WRITE_PVALS=""
 SMOOTHING_PARAM=""
+TWO_STAGE="0"
 
 # Note: Options in the string that are not immediately followed by ':'
 # will not get a value read for them.  Examples are h and P and s.
-while getopts 'hc:C:M:e:f:F:m:n:p:S:w:P' opt; do
+while getopts 'hc:C:M:e:f:F:m:n:p:S:w:P2' opt; do
   case "$opt" in
     h)
       usage
@@ -144,6 +148,9 @@ while getopts 'hc:C:M:e:f:F:m:n:p:S:w:P' opt; do
     w)
       BACKGROUND_WINDOW_SIZE=$((2 * OPTARG + 1))
       ;;
+    2)
+      TWO_STAGE="1"
+      ;;
 
   esac
 done
@@ -188,19 +195,25 @@ BAM=$1
 OUTDIR=$2
 
 log "Checking system for required executables..."
+if [ "$TWO_STAGE" == "1" ]; then
+    require_exes hotspot2_part1 hotspot2_part2
+else
+    require_exes hotspot2_engine
+fi
 if [ "$PEAK_TYPE" == "default_peaks" ]; then
-    require_exes modwt bedGraphToBigWig bedmap samtools hotspot2_part1 hotspot2_part2
+    require_exes modwt bedGraphToBigWig bedmap unstarch samtools
 else
     if [ "$PEAK_TYPE" == "always_summit_centered" ]; then
-	require_exes modwt bedGraphToBigWig bedmap samtools hotspot2_part1 hotspot2_part2 resolveOverlapsInSummit-CenteredPeaks
+	require_exes modwt bedGraphToBigWig bedmap unstarch samtools resolveOverlapsInSummit-CenteredPeaks
     else
-	require_exes modwt bedGraphToBigWig bedmap samtools hotspot2_part1 hotspot2_part2 resolveOverlapsInSummit-CenteredPeaks findVarWidthPeaks
+	require_exes modwt bedGraphToBigWig bedmap unstarch samtools resolveOverlapsInSummit-CenteredPeaks findVarWidthPeaks
     fi
 fi
 
 CUTCOUNT_EXE="$(dirname "$0")/cutcounts.bash"
 DENSPK_EXE="$(dirname "$0")/density-peaks.bash"
 MERGE_EXE="$(dirname "$0")/hsmerge.sh"
+HOTSPOT_EXE=hotspot2_engine
 HOTSPOT_EXE1=hotspot2_part1
 HOTSPOT_EXE2=hotspot2_part2
 
@@ -229,9 +242,6 @@ if [ "$PEAK_TYPE" != "default_peaks" ]; then
     fi
 fi
 
-# Prefer mawk, if installed
-AWK_EXE=$(which mawk 2>/dev/null || which awk)
-
 mkdir -p "$OUTDIR"
 
 base="$OUTDIR/$(basename "$BAM" .bam)"
@@ -245,6 +255,9 @@ DENSITY_OUTFILE="$base.density.starch"
 DENSITY_BW="$base.density.bw"
 PEAKS_OUTFILE="$base.peaks.fdr$HOTSPOT_FDR_THRESHOLD.starch"
 SPOT_SCORE_OUTFILE="$base.SPOT.fdr$HOTSPOT_FDR_THRESHOLD.txt"
+# Each chromosome's P-values are kept here as they're computed, so that a rerun after a failure
+# (e.g., the job was killed) resumes from the first unfinished chromosome.  It's emptied upon success.
+CHECKPOINT_DIR="$base.checkpoint"
 
 clean=0
 if [[ -z "$TMPDIR" ]]; then
@@ -252,33 +265,67 @@ if [[ -z "$TMPDIR" ]]; then
   clean=1
 fi
 
-# temporary files
+# temporary files of the two-stage path (-2)
 TEMP_CHROM_MAPPING_HOTSPOT2PART1=${TMPDIR}/temp_chrom_mapping_hotspot2part1.txt
 TEMP_PVALS=${TMPDIR}/temp_pvals.txt
-TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1=${TMPDIR}/temp_intermediateFile_hotspot2part1.txt
+TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1=${TMPDIR}/temp_intermediateFile_hotspot2part1.bin
 
 log "Generating cut counts..."
 bash "$CUTCOUNT_EXE" "$BAM" "$CUTCOUNTS" "$FRAGMENTS_OUTFILE" "$TOTALCUTS_OUTFILE" "$CHROM_SIZES" $MAPPABLE_REGIONS
 
-if [ ! -s $OUTFILE ] && ([ ! -s $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1 ] || [ ! -s $TEMP_PVALS ] || [ ! -s $TEMP_CHROM_MAPPING_HOTSPOT2PART1 ]) then
-    log "Tallying filtered cut counts in small windows and running part 1 of hotspot2..."
-    bedmap --faster --range "$SITE_NEIGHBORHOOD_HALF_WINDOW_SIZE" --delim "\t" --prec 0 --echo --sum "$CENTER_SITES" "$CUTCOUNTS" \
-	| "$AWK_EXE" 'BEGIN{OFS="\t"}{if("NAN"==$4){$4=0} print $1, $2, $3, "i", $4}' \
-	| "$HOTSPOT_EXE1" --background_size="$BACKGROUND_WINDOW_SIZE" -c $TEMP_CHROM_MAPPING_HOTSPOT2PART1 -p $TEMP_PVALS $SMOOTHING_PARAM -o $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1
-    if [ "$?" != "0" ]; then
-	echo -e "An error occurred when calling bedmap on the \"center sites\" and filtered cut counts file, or while running part 1 of hotspot2."
-	exit 2
+# Part 1 reads the center sites and cut counts through pipes, so it can't check them against its checkpoint;
+# they're identified by name, size and modification time instead, and a checkpoint of other files isn't resumed.
+INPUT_ID=$(stat -L -c '%n %s %Y' "$CENTER_SITES" "$CUTCOUNTS" | paste -s -d ' ' -)
+
+# The output is written to "$OUTFILE.tmp" and renamed once it's complete,
+# so that a failed run doesn't leave behind an $OUTFILE that a rerun would take as done.
+if [ "$TWO_STAGE" == "1" ]; then
+    if [ ! -s $OUTFILE ] && ([ ! -s $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1 ] || [ ! -s $TEMP_PVALS ] || [ ! -s $TEMP_CHROM_MAPPING_HOTSPOT2PART1 ]) then
+	log "Tallying filtered cut counts in small windows and running part 1 of hotspot2..."
+	# hotspot2_part1 tallies the cut counts within the neighborhood of each center site itself.
+	if ! "$HOTSPOT_EXE1" --background_size="$BACKGROUND_WINDOW_SIZE" \
+	    --center_sites=<(unstarch "$CENTER_SITES") --cutcounts=<(unstarch "$CUTCOUNTS") \
+	    --neighborhood_size="$SITE_NEIGHBORHOOD_HALF_WINDOW_SIZE" \
+	    -c $TEMP_CHROM_MAPPING_HOTSPOT2PART1 -p $TEMP_PVALS $SMOOTHING_PARAM \
+	    --checkpoint="$CHECKPOINT_DIR" --resume --input-id="$INPUT_ID" \
+	    --output-format=bin -o $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1; then
+	    echo -e "An error occurred while tallying the \"center sites\" and filtered cut counts files in part 1 of hotspot2."
+	    rm -f $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1 $TEMP_PVALS $TEMP_CHROM_MAPPING_HOTSPOT2PART1
+	    exit 2
+	fi
     fi
-fi
 
-if [ ! -s $OUTFILE ]; then
-    log "Running part 2 of hotspot2..."
-    numEntries=`wc -l < $TEMP_PVALS` # used to aid memory allocation
-    "$HOTSPOT_EXE2" --fdr_threshold="$CALL_THRESHOLD" $WRITE_PVALS \
-       -i $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1 -n $numEntries -c $TEMP_CHROM_MAPPING_HOTSPOT2PART1 -p $TEMP_PVALS \
-       | starch - \
-       >"$OUTFILE"
+    if [ ! -s $OUTFILE ]; then
+	log "Running part 2 of hotspot2..."
+	# The binary intermediate file's header gives its number of entries.
+	if ! "$HOTSPOT_EXE2" --fdr_threshold="$CALL_THRESHOLD" $WRITE_PVALS \
+	    --input-format=bin -i $TEMP_INTERMEDIATE_FILE_HOTSPOT2PART1 -c $TEMP_CHROM_MAPPING_HOTSPOT2PART1 -p $TEMP_PVALS \
+	    | starch - \
+	    >"$OUTFILE.tmp"; then
+	    echo -e "An error occurred while computing FDRs in part 2 of hotspot2."
+	    rm -f "$OUTFILE.tmp"
+	    exit 2
+	fi
+	mv "$OUTFILE.tmp" "$OUTFILE"
+    fi
+elif [ ! -s $OUTFILE ]; then
+    log "Tallying filtered cut counts in small windows and running hotspot2..."
+    # hotspot2_engine tallies the cut counts within the neighborhood of each center site itself,
+    # computes P-values, and then FDRs, spilling site data to $TMPDIR if it exceeds the memory budget.
+    if ! TMPDIR="$TMPDIR" "$HOTSPOT_EXE" --background_size="$BACKGROUND_WINDOW_SIZE" \
+	--center_sites=<(unstarch "$CENTER_SITES") --cutcounts=<(unstarch "$CUTCOUNTS") \
+	--neighborhood_size="$SITE_NEIGHBORHOOD_HALF_WINDOW_SIZE" $SMOOTHING_PARAM \
+	--checkpoint="$CHECKPOINT_DIR" --resume --input-id="$INPUT_ID" \
+	--fdr_threshold="$CALL_THRESHOLD" $WRITE_PVALS \
+	| starch - \
+	>"$OUTFILE.tmp"; then
+	echo -e "An error occurred while tallying the \"center sites\" and filtered cut counts files, or computing P-values or FDRs, in hotspot2."
+	rm -f "$OUTFILE.tmp"
+	exit 2
+    fi
+    mv "$OUTFILE.tmp" "$OUTFILE"
 fi
+rm -rf "$CHECKPOINT_DIR" # no longer needed, now that $OUTFILE is complete
 
 if [ ! -s $HOTSPOT_OUTFILE ]; then
     log "Calling hotspots..."
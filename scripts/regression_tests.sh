@@ -0,0 +1,220 @@
+#!/bin/bash
+
+usage() {
+  cat >&2 <<__EOF__
+Usage:  "$0" [options] BINDIR [TEST ...]
+
+Runs regression tests against the executables in BINDIR, each on a small input
+(most are cut from the output of scripts/synthetic_cutcounts.sh, which is deterministic),
+and reports PASS or FAIL for each.  With no TEST arguments, all tests are run.
+The exit status is 1 if any test fails.  "make check" runs them all.
+
+Options:
+    -h                 Show this helpful help
+    -l                 List the tests, and exit
+    -w WORKDIR         Keep each test's inputs and outputs in WORKDIR/TEST (a temporary directory)
+__EOF__
+  exit 2
+}
+
+# Each test is a function named test_NAME, run in its own (empty) working directory,
+# that returns nonzero upon failure, after explaining why on stderr.
+TESTS=(
+  degenerate_window
+  genome_sized_histogram
+  corrupt_binary_input
+  unknown_chromosome
+  streamed_checkpoint_identity
+  sliding_cutoff_after_slide
+  sliding_cutoff_across_gap
+)
+
+WORKDIR=
+
+while getopts 'hlw:' opt; do
+  case "$opt" in
+    h) usage ;;
+    l) printf '%s\n' "${TESTS[@]}"; exit 0 ;;
+    w) WORKDIR=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+
+shift $((OPTIND - 1))
+
+if [[ $# -lt 1 ]]; then
+  usage
+fi
+
+BINDIR=$(cd "$1" && pwd) || exit 2
+shift
+SCRIPTDIR=$(cd "$(dirname "$0")" && pwd)
+if [[ $# -gt 0 ]]; then
+  TESTS=("$@")
+fi
+
+if [[ -z "$WORKDIR" ]]; then
+  WORKDIR=$(mktemp -d /tmp/hotspot2_tests.XXXXXX) || exit 2
+  trap 'rm -rf "$WORKDIR"' EXIT
+fi
+mkdir -p "$WORKDIR" || exit 2
+WORKDIR=$(cd "$WORKDIR" && pwd)
+
+# synthetic NAME NUM_LINES [synthetic_cutcounts.sh options]
+# Writes the first NUM_LINES lines of synthetic_cutcounts.sh's output to NAME, once per run of this script.
+synthetic() {
+  local name=$1 numLines=$2
+  shift 2
+  if [[ ! -s "$WORKDIR/$name" ]]; then
+    "$SCRIPTDIR/synthetic_cutcounts.sh" "$@" | head -n "$numLines" > "$WORKDIR/$name"
+  fi
+}
+
+# A background window that's narrow enough to see nothing but 0s and 1s gets a degenerate null model,
+# whose P-values aren't numbers; they must be scored 0 rather than crash hotspot2_part1.
+test_degenerate_window() {
+  synthetic small.bed 20000
+  "$BINDIR/hotspot2_part1" -b 101 -i "$WORKDIR/small.bed" -c chroms.txt -p pvals.txt > out.txt 2> err.txt
+  local rc=$?
+  if [[ $rc -ne 0 ]]; then
+    echo "hotspot2_part1 exited with status $rc:" >&2
+    cat err.txt >&2
+    return 1
+  fi
+  if ! grep -q "all counts used for statistics were 0" err.txt; then
+    echo "The input no longer contains a degenerate window." >&2
+    return 1
+  fi
+  if awk '$3 < 0 { exit 0 } END { exit 1 }' out.txt || awk '$1 < 0 { exit 0 } END { exit 1 }' pvals.txt; then
+    echo "A negative score was written." >&2
+    return 1
+  fi
+}
+
+# On a whole genome, more than INT_MAX sites can share score 0; hotspot2_part2 must count all of them.
+# With N = 3e9 + 10 P-values, the 10 with P = 1e-9 (score 9000) get FDR = 1e-9 * N / 10 = 0.3.
+test_genome_sized_histogram() {
+  printf '1\tchr1\n' > chroms.txt
+  printf '0\t3000000000\n9000\t10\n' > pvals.txt
+  printf '1\t0\t1\t9000\n' > sites.txt
+  "$BINDIR/hotspot2_part2" -p pvals.txt -c chroms.txt -i sites.txt > out.bed || return 1
+  if [[ "$(cut -f5 out.bed)" != "0.3" ]]; then
+    echo "Expected FDR 0.3, but hotspot2_part2 wrote:" >&2
+    cat out.bed >&2
+    return 1
+  fi
+}
+
+# A block header in binary input whose chromosome name claims 4 GB must be rejected as corrupt,
+# not allocated.
+test_corrupt_binary_input() {
+  printf 'HS2BIN01\377\377\377\377' > bad.bin
+  if "$BINDIR/hotspot2_part1" -F bin -i bad.bin -c chroms.txt -p pvals.txt > out.txt 2> err.txt; then
+    echo "hotspot2_part1 accepted the corrupt input." >&2
+    return 1
+  fi
+  if ! grep -q "is corrupt.*chromosome name of 4294967295 bytes" err.txt; then
+    echo "hotspot2_part1 did not report the corrupt chromosome name:" >&2
+    cat err.txt >&2
+    return 1
+  fi
+}
+
+# A site whose chromosome ID isn't in the file of chromosome names is an input error, reported as such.
+test_unknown_chromosome() {
+  printf '1\tchr1\n' > chroms.txt
+  printf '0\t10\n' > pvals.txt
+  printf '1\t0\t1\t0\n2\t0\t1\t0\n' > sites.txt
+  if "$BINDIR/hotspot2_part2" -p pvals.txt -c chroms.txt -i sites.txt > out.bed 2> err.txt; then
+    echo "hotspot2_part2 accepted a site on an unknown chromosome." >&2
+    return 1
+  fi
+  if ! grep -q "has chromosome 2, which is not in the file of chromosome names" err.txt; then
+    echo "hotspot2_part2 did not report the unknown chromosome:" >&2
+    cat err.txt >&2
+    return 1
+  fi
+}
+
+# A checkpoint of piped input is resumed only by a run whose --input-id matches the one that wrote it:
+# input A fails on chr2, leaving chr1 done; piping in input B with B's ID, or with none, must start over,
+# while piping in A again with A's ID must resume, and either way the output must be that of a fresh run.
+test_streamed_checkpoint_identity() {
+  "$SCRIPTDIR/synthetic_cutcounts.sh" -c 2 -l 20000 > a.bed
+  "$SCRIPTDIR/synthetic_cutcounts.sh" -c 2 -l 20000 -s 7 > b.bed
+  (grep -P '^chr1\t' a.bed; grep -P '^chr2\t' a.bed | head -n 100; printf 'chr2\tx\n') > a_bad.bed
+  local part1="$BINDIR/hotspot2_part1 -b 1001 -c chroms.txt -p pvals.txt"
+  $part1 -i a.bed > a.fresh && $part1 -i b.bed > b.fresh || return 1
+
+  local run id in expected
+  for run in B:b:started_over :b:started_over A:a:resumed; do
+    IFS=: read -r id in expected <<< "$run"
+    rm -rf ck
+    if cat a_bad.bed | $part1 --checkpoint=ck --input-id=A > /dev/null 2>&1 || [[ ! -e ck/1.done ]]; then
+      echo "The failed run didn't leave a checkpoint of chr1." >&2
+      return 1
+    fi
+    cat $in.bed | $part1 --checkpoint=ck --resume ${id:+--input-id=$id} > out.txt 2> err.txt || return 1
+    if ! cmp -s out.txt $in.fresh; then
+      echo "Resuming with --input-id \"$id\" on input $in gave other output than a fresh run." >&2
+      return 1
+    fi
+    if grep -q "starting over" err.txt; then
+      [[ $expected == started_over ]] && continue
+    elif [[ $expected == resumed ]]; then
+      continue
+    fi
+    echo "Resuming with --input-id \"$id\" on input $in should have $expected (with \"starting over\" on stderr if not):" >&2
+    cat err.txt >&2
+    return 1
+  done
+}
+
+# verify_sliding_cutoff INPUT
+# Runs hotspot2_part1 --verify=1 on INPUT, so that the cutoff it maintains while sliding the background window
+# gets checked against one recomputed from scratch at every slide.
+verify_sliding_cutoff() {
+  if ! "$BINDIR/hotspot2_part1" --verify=1 -i "$1" -c chroms.txt -p pvals.txt > out.txt 2> err.txt; then
+    echo "hotspot2_part1 --verify=1 failed on $1:" >&2
+    cat err.txt >&2
+    return 1
+  fi
+}
+
+# A slide in which one count leaves the background window and another enters can lower an MAxN value
+# left of the cutoff enough for one to its right to mark a new "trend reversal," without zeroing any of them;
+# the cutoff must then be recomputed.  Without that, the window chr1:40318-90318 of this input
+# keeps a cutoff of 142 where recomputing gives 93.
+test_sliding_cutoff_after_slide() {
+  synthetic d50.bed 91000 -c 1 -d 50
+  awk '$2 >= 40000' "$WORKDIR/d50.bed" > in.bed
+  verify_sliding_cutoff in.bed
+}
+
+# The same holds for the slides across a gap in the input, in which counts leave and none enter.
+# Without that, the window chr1:1227374-1277374 of this input keeps a cutoff of 133 where recomputing gives 109.
+test_sliding_cutoff_across_gap() {
+  "$SCRIPTDIR/synthetic_cutcounts.sh" -c 1 -l 1285000 -s 3 -d 50 -g 60 -G 3000 | awk '$2 >= 1227000' > in.bed
+  verify_sliding_cutoff in.bed
+}
+
+numFailed=0
+for t in "${TESTS[@]}"; do
+  if [[ "$(type -t "test_$t")" != "function" ]]; then
+    echo "Error:  there's no test named \"$t\"; $0 -l lists them." >&2
+    exit 2
+  fi
+  rm -rf "$WORKDIR/$t"
+  mkdir -p "$WORKDIR/$t" || exit 2
+  if (cd "$WORKDIR/$t" && "test_$t"); then
+    echo "PASS  $t"
+  else
+    echo "FAIL  $t"
+    numFailed=$((numFailed + 1))
+  fi
+done
+
+if [[ $numFailed -ne 0 ]]; then
+  echo "$numFailed of ${#TESTS[@]} tests failed." >&2
+  exit 1
+fi
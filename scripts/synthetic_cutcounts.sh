@@ -0,0 +1,144 @@
+#!/bin/bash
+
+usage() {
+  cat >&2 <<__EOF__
+Usage:  "$0" [options] > tallies.bed
+
+Writes synthetic input for hotspot2_part1 to stdout:  BED5 lines (chrom, beg, end, ID, count),
+one per mappable bp, where the count is the number of cuts within RADIUS bp of the site,
+as hotspot2.sh tallies them around the center sites.  Output is deterministic for a given seed.
+
+Cuts are drawn per bp from a Poisson distribution whose rate is scaled by a gamma-distributed factor
+(mean 1) for each block of 1 kb, so that the tallies follow a negative binomial background.
+Hotspots, in which the rate is multiplied 3- to 20-fold over 150-1500 bp, are planted at random,
+as are unmappable gaps, for which no lines are written.  Gap lengths are exponentially distributed,
+so that some are narrower and some wider than half of hotspot2_part1's background window.
+
+Options:
+    -h                 Show this helpful help
+
+    -c NUM_CHROMS      Number of chromosomes                              (4)
+    -l LENGTH          Length of each chromosome, in bp                   (2000000)
+    -d DEPTH           Mean count (cuts per 2*RADIUS+1 bp) outside hotspots (30)
+    -k SHAPE           Shape of the gamma distribution of the rate;
+                       smaller values give a more overdispersed background  (4)
+    -H HOTSPOTS        Hotspots planted per Mb                            (50)
+    -g GAPS            Gaps per Mb                                        (5)
+    -G GAP_LENGTH      Mean gap length, in bp                             (20000)
+    -r RADIUS          Tally the cuts within RADIUS bp of each site       (100)
+    -s SEED            Random seed                                        (12345)
+__EOF__
+  exit 2
+}
+
+NUM_CHROMS=4
+LENGTH=2000000
+DEPTH=30
+SHAPE=4
+HOTSPOTS_PER_MB=50
+GAPS_PER_MB=5
+GAP_LENGTH=20000
+RADIUS=100
+SEED=12345
+
+AWK_EXE=$(which mawk 2>/dev/null || which awk)
+
+while getopts 'hc:l:d:k:H:g:G:r:s:' opt; do
+  case "$opt" in
+    h) usage ;;
+    c) NUM_CHROMS=$OPTARG ;;
+    l) LENGTH=$OPTARG ;;
+    d) DEPTH=$OPTARG ;;
+    k) SHAPE=$OPTARG ;;
+    H) HOTSPOTS_PER_MB=$OPTARG ;;
+    g) GAPS_PER_MB=$OPTARG ;;
+    G) GAP_LENGTH=$OPTARG ;;
+    r) RADIUS=$OPTARG ;;
+    s) SEED=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+
+shift $((OPTIND - 1))
+
+if [[ $# -ne 0 ]]; then
+  usage
+fi
+
+"$AWK_EXE" -v nchroms="$NUM_CHROMS" -v len="$LENGTH" -v depth="$DEPTH" -v shape="$SHAPE" \
+  -v hsrate="$HOTSPOTS_PER_MB" -v gaprate="$GAPS_PER_MB" -v gaplen="$GAP_LENGTH" \
+  -v radius="$RADIUS" -v seed="$SEED" '
+  function normal() {
+    return sqrt(-2 * log(1 - rand())) * cos(6.283185307179586 * rand())
+  }
+  # Marsaglia and Tsang; for shape < 1, gamma(shape + 1) * U^(1/shape).
+  function gamma(a,    boost, d, c, x, v, u) {
+    boost = 1
+    if (a < 1) {
+      boost = (1 - rand()) ^ (1 / a)
+      a++
+    }
+    d = a - 1 / 3
+    c = 1 / sqrt(9 * d)
+    for (;;) {
+      do {
+        x = normal()
+        v = 1 + c * x
+      } while (v <= 0)
+      v = v * v * v
+      u = 1 - rand()
+      if (log(u) < 0.5 * x * x + d - d * v + d * log(v))
+        return boost * d * v
+    }
+  }
+  function poisson(lambda,    L, k, p) {
+    L = exp(-lambda)
+    k = 0
+    p = rand()
+    while (p > L) {
+      k++
+      p *= rand()
+    }
+    return k
+  }
+  BEGIN {
+    srand(seed)
+    w = 2 * radius + 1
+    baseRate = depth / w
+    for (c = 1; c <= nchroms; c++) {
+      chrom = "chr" c
+      for (i = 0; i < w; i++) {
+        cuts[i] = 0
+        mappable[i] = 0
+      }
+      sum = 0
+      gapLeft = hsLeft = 0
+      fold = 1
+      for (pos = 0; pos < len; pos++) {
+        if (0 == pos % 1000)
+          blockRate = baseRate * gamma(shape) / shape
+        if (gapLeft > 0)
+          gapLeft--
+        else if (rand() * 1000000 < gaprate)
+          gapLeft = int(-log(1 - rand()) * gaplen)
+        if (hsLeft > 0)
+          hsLeft--
+        else {
+          fold = 1
+          if (rand() * 1000000 < hsrate) {
+            hsLeft = 150 + int(rand() * 1350)
+            fold = 3 + rand() * 17
+          }
+        }
+        i = pos % w
+        sum -= cuts[i]
+        cuts[i] = (gapLeft > 0) ? 0 : poisson(blockRate * fold)
+        mappable[i] = (gapLeft > 0) ? 0 : 1
+        sum += cuts[i]
+        # The window centered on pos - radius is now complete.
+        ctr = pos - radius
+        if (ctr >= 0 && mappable[ctr % w])
+          printf "%s\t%d\t%d\ti\t%d\n", chrom, ctr, ctr + 1, sum
+      }
+    }
+  }'
@@ -0,0 +1,170 @@
+// Peaks of normalized density, as found by findVarWidthPeaks:  the Positions of each contiguous Region,
+// the Ranges they form, and getPeakBoundaries(), which finds the full-width-at-half-maximum bounds
+// of the peak around a local maximum.
+//
+#ifndef FINDVARWIDTHPEAKS_H
+#define FINDVARWIDTHPEAKS_H
+
+#include <cmath>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct Position {
+  long x;  // genomic coordinate
+  float y; // score (e.g. normalized density)
+  int idx; // index into a vector of (contiguous) Positions
+};
+
+// As the name implies, Range is a generic range of contiguous Positions,
+// bounded on the left by "beg" and on the right by "end."
+// (Each Range is inclusive of "beg" and "end," i.e.,
+// a 0-based Range gets output as (beg-1, end].)
+// In practice, a Range is used to store boundaries of local maxima
+// and peaks (which begin life as local maxima).
+struct Range {
+  string chrom;
+  string id;
+  Position beg;
+  Position end;
+  float maxY;
+  long x_of_maxY;
+  long inputSummit; // wavelet summit
+  long summitSeparation;
+};
+
+// Each contiguous "island" of bp in the input file gets called a "Region."
+// Each Region is made up of Positions, some (or all) of which define local maxima.
+// A local maximum usually gets identified as a peak, but sometimes it's a shoulder of a peak.
+struct Region {
+  string chrom;
+  string id;
+  long posSummit; // wavelet summit
+  vector<Position> posns;
+  list<Range> localMaxima;
+};
+
+// Function for sorting Ranges in descending order by height.
+// (The height is maxY, but when this function is actually called,
+// all sites within each Range have the same height.)
+// If two Ranges have the same height, they get sorted in genomic order.
+bool Height_GT(const Range& a, const Range& b);
+bool Height_GT(const Range& a, const Range& b)
+{
+  if (fabs(a.maxY - b.maxY) < 0.0001) // == on floating-point numbers
+    {
+      if (a.beg.x == b.beg.x)
+	return a.end.x < b.end.x;
+      return a.beg.x < b.beg.x;
+    }
+  return a.maxY > b.maxY;
+}
+
+// Function for sorting Ranges in genomic order.
+bool GenomicOrder_LT(const Range& a, const Range& b);
+bool GenomicOrder_LT(const Range& a, const Range& b)
+{
+  if (a.chrom == b.chrom)
+    {
+      if (a.beg.x == b.beg.x)
+	{
+	  if (a.end.x == b.end.x)
+	    return a.inputSummit < b.inputSummit;
+	  return a.end.x < b.end.x;
+	}
+      return a.beg.x < b.beg.x;
+    }
+  return a.chrom < b.chrom;
+}
+
+// This function finds the boundaries of the peak
+// whose local maximum is the contiguous region bounded by [reg.posns[idxL], reg.posns[idxR]].
+// A boundary point is the first site before the first site where the height dips below half-maximum,
+// or the corresponding local minimum if half-maximum is not attained,
+// or the end of the Region, whichever comes first.
+// The slots within the vector of Positions, idxL and idxR,
+// will correspond to the locations of those bounds when this function returns.
+// The return value will be true unless the peak found is < minWidth bp wide or doesn't enclose the current posSummit.
+bool getPeakBoundaries(const Region& r, int& idxL, int& idxR, const long& minWidth);
+bool getPeakBoundaries(const Region& r, int& idxL, int& idxR, const long& minWidth)
+{
+  float maxY(r.posns[idxL].y), halfmaxY(r.posns[idxL].y/2.0), minY(maxY);
+  const float secondaryCutoff(999999. * maxY); // ensures we always return the local min when we fail to achieve half-max
+  const int maxIdx = static_cast<int>(r.posns.size()) - 1; // in English: "maximum index," not "idx of max"
+  int idxOfLocalMin(idxL);
+
+  if (idxL > 0)
+    idxL--; // begin our search at the first site to the left of the local maximum
+  while (idxL > 0 && (r.posns[idxL].y - halfmaxY) > 0.0001) // the L boundary of the Region has index = 0
+    {
+      if (r.posns[idxL].y < minY || r.posns[idxL].y - minY < 0.0001) // i.e., "if y <= minY"
+	{
+	  minY = r.posns[idxL].y;
+	  idxOfLocalMin = idxL;
+	}
+      if (r.posns[idxL].y - maxY > -0.0001) // i.e., "if y >= maxY"
+	{
+	  // While searching for the half-max point to the left of the local max,
+	  // we climbed above the local max, so this is a subset of another peak...
+	  // but we want to give it a chance to get called as a peak, so we backtrack to the local min.
+	  idxL = idxOfLocalMin;
+	  if (secondaryCutoff - r.posns[idxL].y > 0.0001)
+	    break;
+	  else
+	    return false; // we'll actually never hit this line unless we change the algorithm
+	}
+      else
+	idxL--;
+    }
+  if (halfmaxY - r.posns[idxL].y > -0.0001) // i.e., "if halfmaxY >= y"
+    idxL++;
+  else
+    {
+      if (0 == idxL && r.posns[idxL].y > minY)
+	idxL = idxOfLocalMin;
+    }
+
+  idxOfLocalMin = idxR;
+  minY = maxY;
+  if (idxR < maxIdx)
+    idxR++; // begin our search at the first site to the right of the local maximum
+  while (idxR < maxIdx && (r.posns[idxR].y - halfmaxY) > 0.0001) // the R boundary of the Region has index = maxIdx
+    {
+      if (r.posns[idxR].y < minY || r.posns[idxR].y - minY < 0.0001) // i.e., "if y <= minY"
+	{
+	  minY = r.posns[idxR].y;
+	  idxOfLocalMin = idxR;
+	}
+      if (r.posns[idxR].y - maxY > - 0.0001) // i.e., "if y >= maxY"
+	{
+	  // While searching for the half-max point to the left of the local max,
+	  // we climbed above the local max, so this is a subset of another peak...
+	  // but we want to give it a chance to get called as a peak, so we backtrack to the local min.
+	  idxR = idxOfLocalMin;
+	  if (secondaryCutoff - r.posns[idxR].y > 0.0001)
+	    break;
+	  else
+	    return false; // we'll actually never hit this line unless we change the algorithm
+	}
+      else
+	idxR++;
+    }
+  if (halfmaxY - r.posns[idxR].y > -0.0001) // i.e., "if halfmax >= y"
+    idxR--;
+  else
+    {
+      if (maxIdx == idxR && r.posns[idxR].y > minY)
+	idxR = idxOfLocalMin;
+    }
+
+  // Require the peak to contain the posSummit received for this region.
+  if (r.posSummit < r.posns[idxL].x || r.posSummit > r.posns[idxR].x)
+    return false;
+  if (idxR - idxL + 1 >= minWidth) // 0-based sites (100,120] are the 20 sites from 101-120; could have, e.g., idxL = 0 and idxR = 19 in this case
+    return true;
+  return false;
+}
+
+#endif // FINDVARWIDTHPEAKS_H
@@ -0,0 +1,247 @@
+// To compile this code into an executable,
+// simply enter the command
+//
+// $ g++ -O3 hotspot2_bed2bin.cpp -o hotspot2_bed2bin
+//
+// or substitute any desired name for the executable for the last argument.
+// The argument -O3 (capital "oh") generates optimized code;
+// it can be omitted if desired.
+// Any C++ compiler can be used in place of g++.
+//
+// This program converts the BED5 input of hotspot2_part1 (chrom, beg, end, ID, count)
+// into the binary format described in hotspot2_binary_input.h,
+// which hotspot2_part1 reads when it's given --input-format=bin.
+// Abutting lines with equal counts are combined into a single run.
+//
+#include "hotspot2_binary_input.h"
+#include "hotspot2_tsv.h"
+#include "hotspot2_version.h" // for versioning
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Records for a chromosome are buffered in memory,
+// because the block header gives their number and size.
+class BlockWriter {
+public:
+  BlockWriter(ostream& os) : m_os(os), m_numRecords(0), m_prevEnd(0), m_runStart(-1), m_runEnd(-1), m_runCount(-1) {};
+  void startBlock(const string& chrom);
+  bool addRange(const long& start, const long& end, const int& count, const long& linenum);
+  void finishBlock(void);
+
+private:
+  BlockWriter(const BlockWriter&); // deny use of the copy constructor
+  void writeRun(void);
+  ostream& m_os;
+  ostringstream m_records;
+  string m_chrom;
+  unsigned long m_numRecords;
+  long m_prevEnd;
+  long m_runStart;
+  long m_runEnd;
+  int m_runCount;
+};
+
+void BlockWriter::startBlock(const string& chrom)
+{
+  m_chrom = chrom;
+  m_records.str("");
+  m_numRecords = 0;
+  m_prevEnd = 0;
+  m_runStart = m_runEnd = -1;
+  m_runCount = -1;
+}
+
+bool BlockWriter::addRange(const long& start, const long& end, const int& count, const long& linenum)
+{
+  if (start < m_prevEnd || (m_runEnd != -1 && start < m_runEnd) || end < start || count < 0)
+    {
+      cerr << "Error:  Line " << linenum << " (" << m_chrom << '\t' << start << '\t' << end
+           << ") is out of order, overlaps the previous line, or has a negative count." << endl
+           << endl;
+      return false;
+    }
+  if (start == end)
+    return true;
+  if (m_runEnd == start && m_runCount == count)
+    {
+      m_runEnd = end;
+      return true;
+    }
+  writeRun();
+  m_runStart = start;
+  m_runEnd = end;
+  m_runCount = count;
+  return true;
+}
+
+void BlockWriter::writeRun(void)
+{
+  if (-1 == m_runEnd)
+    return;
+  writeVarint(m_records, static_cast<unsigned long>(m_runStart - m_prevEnd));
+  writeVarint(m_records, static_cast<unsigned long>(m_runEnd - m_runStart));
+  writeVarint(m_records, static_cast<unsigned long>(m_runCount));
+  m_numRecords++;
+  m_prevEnd = m_runEnd;
+}
+
+void BlockWriter::finishBlock(void)
+{
+  writeRun();
+  if (0 == m_numRecords)
+    return;
+  const string records(m_records.str());
+  writeFixedWidth(m_os, m_chrom.size(), 4);
+  m_os.write(m_chrom.data(), m_chrom.size());
+  writeFixedWidth(m_os, m_numRecords, 8);
+  writeFixedWidth(m_os, records.size(), 8);
+  m_os.write(records.data(), records.size());
+}
+
+bool convert(istream& is, ostream& os);
+bool convert(istream& is, ostream& os)
+{
+  LineReader lines(is);
+  char* fields[5];
+  long linenum(0), start, end;
+  int numFields, count;
+  string curChrom;
+  BlockWriter bw(os);
+
+  os.write(HOTSPOT2_BIN_MAGIC, HOTSPOT2_BIN_MAGIC_LENGTH);
+
+  while (lines.next())
+    {
+      linenum++;
+      numFields = splitFields(lines.line(), lines.length(), '\t', fields, 5);
+      if (numFields < 5 || !*fields[0])
+        {
+          cerr << "Error:  Missing required field " << (!*fields[0] ? 1 : numFields + 1)
+               << " on line " << linenum << "." << endl
+               << endl;
+          return false;
+        }
+      const size_t chromLength(fields[1] - fields[0] - 1);
+      if (chromLength > HOTSPOT2_BIN_MAX_CHROM_NAME_LENGTH)
+        {
+          cerr << "Error:  The chromosome name on line " << linenum << " is longer than "
+               << HOTSPOT2_BIN_MAX_CHROM_NAME_LENGTH << " characters." << endl
+               << endl;
+          return false;
+        }
+      if (1 == linenum || !sameName(curChrom, fields[0], chromLength))
+        {
+          if (linenum != 1)
+            bw.finishBlock();
+          curChrom.assign(fields[0], chromLength);
+          bw.startBlock(curChrom);
+        }
+      start = parseLong(fields[1]);
+      end = parseLong(fields[2]);
+      count = parseInt(fields[4]);
+      if (!bw.addRange(start, end, count, linenum))
+        return false;
+    }
+  if (linenum > 0)
+    bw.finishBlock();
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  int print_help = 0;
+  int print_version = 0;
+  string infilename = "";
+  string outfilename = "";
+
+  static struct option long_options[] = {
+    { "input", required_argument, 0, 'i' },
+    { "output", required_argument, 0, 'o' },
+    { "help", no_argument, &print_help, 1 },
+    { "version", no_argument, &print_version, 1 },
+    { 0, 0, 0, 0 }
+  };
+
+  char c;
+  while ((c = getopt_long(argc, argv, "i:o:hvV", long_options, NULL)) != -1)
+    {
+      switch (c)
+        {
+        case 'i':
+          infilename = optarg;
+          break;
+        case 'o':
+          outfilename = optarg;
+          break;
+        case 'h':
+          print_help = 1;
+          break;
+        case 'v':
+        case 'V':
+          print_version = 1;
+          break;
+        case 0:
+          // long option received, do nothing
+          break;
+        default:
+          print_help = 1;
+        }
+    }
+
+  if (print_help)
+    {
+      cerr << "Usage:  " << argv[0] << " [options] < in.cutcounts.bed > out.bin\n"
+           << "\n"
+           << "Converts hotspot2_part1's BED5 input (IDs in field 4, counts in field 5)\n"
+           << "into the binary format read by hotspot2_part1 --input-format=bin.\n"
+           << "\n"
+           << "Options: \n"
+           << "  -i, --input=FILE               A file to read input from (STDIN)\n"
+           << "  -o, --output=FILE              A file to write output to (STDOUT)\n"
+           << "  -v, --version                  Print the version information and exit\n"
+           << "  -h, --help                     Display this helpful help\n"
+           << endl
+           << endl;
+      return -1;
+    }
+
+  if (print_version)
+    {
+      cout << argv[0] << " version " << hotspot2_VERSION_MAJOR
+           << '.' << hotspot2_VERSION_MINOR << endl;
+      return 0;
+    }
+
+  ios_base::sync_with_stdio(false); // calling this static method in this way turns off checks, speeds up I/O
+
+  if (!infilename.empty() && infilename != "-")
+    {
+      if (freopen(infilename.c_str(), "r", stdin) == NULL)
+        {
+          cerr << "Error: Couldn't open input file " << infilename << endl;
+          return 1;
+        }
+    }
+  if (!outfilename.empty() && outfilename != "-")
+    {
+      if (freopen(outfilename.c_str(), "w", stdout) == NULL)
+        {
+          cerr << "Error: Couldn't open output file " << outfilename << " for writing" << endl;
+          return 1;
+        }
+    }
+
+  if (!convert(cin, cout))
+    return -1;
+
+  return 0;
+}
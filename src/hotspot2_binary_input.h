@@ -0,0 +1,89 @@
+// Binary input format for hotspot2_part1 (--input-format=bin),
+// written by hotspot2_bed2bin from the BED5 input that hotspot2_part1 otherwise reads.
+//
+// The stream begins with the 8-byte magic string "HS2BIN01".
+// It is followed by one block per chromosome.  (As with BED input, a chromosome may appear
+// in more than one block; consecutive blocks for the same chromosome are treated as one.)
+// Each block consists of
+//
+//   uint32    length of the chromosome name, in bytes (at most HOTSPOT2_BIN_MAX_CHROM_NAME_LENGTH)
+//   char[]    the chromosome name (not null-terminated)
+//   uint64    number of records in the block
+//   uint64    number of bytes of record data that follow
+//   records
+//
+// Each record describes a run of sites (1 bp each) with the same count,
+// and consists of three unsigned LEB128 varints:
+//
+//   delta     start of this run minus the end of the previous run in the block
+//             (for the first run in the block, the start itself)
+//   length    number of sites in the run, i.e., end - start
+//   count     the count observed at each site in the run
+//
+// For example, the BED5 lines "chr1 100 101 i 7" and "chr1 101 103 i 7" become
+// one record with delta 100, length 3, count 7.
+// Fixed-width integers are little-endian.  Runs must be sorted and non-overlapping.
+//
+#ifndef HOTSPOT2_BINARY_INPUT_H
+#define HOTSPOT2_BINARY_INPUT_H
+
+#include <iostream>
+#include <string>
+
+const char HOTSPOT2_BIN_MAGIC[] = "HS2BIN01";
+const int HOTSPOT2_BIN_MAGIC_LENGTH(8);
+const unsigned long HOTSPOT2_BIN_MAX_CHROM_NAME_LENGTH(4096); // a longer one means the input is corrupt
+
+inline void writeVarint(std::ostream& os, unsigned long val)
+{
+  while (val >= 0x80)
+    {
+      os.put(static_cast<char>((val & 0x7f) | 0x80));
+      val >>= 7;
+    }
+  os.put(static_cast<char>(val));
+}
+
+// Returns false at end of input or if the varint is truncated or malformed.
+// numBytes is incremented by the number of bytes consumed.
+inline bool readVarint(std::streambuf* sb, unsigned long& val, std::streamoff& numBytes)
+{
+  int shift(0), c;
+  val = 0;
+  while ((c = sb->sbumpc()) != std::char_traits<char>::eof())
+    {
+      numBytes++;
+      val |= static_cast<unsigned long>(c & 0x7f) << shift;
+      if (!(c & 0x80))
+        return true;
+      shift += 7;
+      if (shift > 63)
+        return false;
+    }
+  return false;
+}
+
+inline void writeFixedWidth(std::ostream& os, unsigned long val, const int& numBytes)
+{
+  for (int i = 0; i < numBytes; i++)
+    {
+      os.put(static_cast<char>(val & 0xff));
+      val >>= 8;
+    }
+}
+
+// Returns false if fewer than numBytes bytes remain in the input.
+inline bool readFixedWidth(std::streambuf* sb, unsigned long& val, const int& numBytes)
+{
+  val = 0;
+  for (int i = 0; i < numBytes; i++)
+    {
+      int c = sb->sbumpc();
+      if (std::char_traits<char>::eof() == c)
+        return false;
+      val |= static_cast<unsigned long>(c & 0xff) << (8 * i);
+    }
+  return true;
+}
+
+#endif // HOTSPOT2_BINARY_INPUT_H
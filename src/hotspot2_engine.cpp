@@ -0,0 +1,344 @@
+// To compile this code into an executable,
+// simply enter the command
+//
+// $ g++ -O3 -pthread hotspot2_engine.cpp -o hotspot2_engine
+//
+// or substitute any desired name for the executable for the last argument.
+// The argument -O3 (capital "oh") generates optimized code;
+// it can be omitted if desired.
+// Any C++ compiler can be used in place of g++.
+//
+// This program does the work of hotspot2_part1 followed by hotspot2_part2 in a single process.
+// Part 1's site ranges are held in a spill buffer, in the binary format of hotspot2_intermediate.h,
+// and its histogram of scores is kept in memory; at the end of the input, the FDR table is built
+// from the histogram, and the output is streamed straight from the spill buffer.
+// The output is identical to that of hotspot2_part2.
+// With --checkpoint, part 1's output is kept per chromosome as it would be by hotspot2_part1, and a resumed run
+// takes the completed chromosomes' site ranges and histograms from the checkpoint and redoes part 2 from there.
+//
+#include "hotspot2_fdr.h"
+#include "hotspot2_options.h"
+#include "hotspot2_version.h" // for versioning
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Holds the site-range records written by SiteManager until the FDR table is ready.
+// Records accumulate in memory until they would exceed memoryBudget bytes; then they're written
+// to a temporary file, which receives all subsequent records as well.
+// The file is given the header of hotspot2_intermediate.h, so it can be read like part2's input.
+class SpillBuffer : public streambuf {
+public:
+  SpillBuffer(const size_t& memoryBudget);
+  ~SpillBuffer();
+  bool finish(void); // flush, and fill in the spill file's header
+  bool spilled(void) const { return !m_filename.empty(); };
+  const string& filename(void) const { return m_filename; };
+  const char* records(void) const { return m_mem.empty() ? NULL : &m_mem[0]; };
+  unsigned long numRecordsInMemory(void) const { return m_numBytesInMemory / HOTSPOT2_INTERMEDIATE_RECORD_SIZE; };
+
+protected:
+  virtual int_type overflow(int_type c);
+
+private:
+  SpillBuffer(); // require the above constructor to be used
+  SpillBuffer(const SpillBuffer&); // deny use of the copy constructor
+  bool writeToFile(void);
+  void resetPutArea(const size_t& numBytesUsed);
+  vector<char> m_mem;
+  size_t m_budget;
+  string m_filename;
+  ofstream m_ofs;
+  unsigned long m_numBytesInFile;
+  unsigned long m_numBytesInMemory;
+  bool m_failed;
+};
+
+SpillBuffer::SpillBuffer(const size_t& memoryBudget)
+  : m_budget(max(memoryBudget, static_cast<size_t>(HOTSPOT2_INTERMEDIATE_RECORD_SIZE))),
+    m_numBytesInFile(0), m_numBytesInMemory(0), m_failed(false)
+{
+  setp(NULL, NULL);
+}
+
+SpillBuffer::~SpillBuffer()
+{
+  if (m_ofs.is_open())
+    m_ofs.close();
+  if (spilled())
+    remove(m_filename.c_str());
+}
+
+// Point the put area at m_mem, with the first numBytesUsed bytes already written.
+void SpillBuffer::resetPutArea(const size_t& numBytesUsed)
+{
+  setp(&m_mem[0], &m_mem[0] + m_mem.size());
+  size_t n(numBytesUsed);
+  while (n > 0)
+    {
+      const int step = static_cast<int>(min(n, static_cast<size_t>(1 << 30))); // pbump() takes an int
+      pbump(step);
+      n -= step;
+    }
+}
+
+bool SpillBuffer::writeToFile(void)
+{
+  if (!spilled())
+    {
+      if (!createTempFile(m_filename))
+	return false;
+      m_ofs.open(m_filename.c_str(), ios::binary);
+      if (!m_ofs)
+	{
+	  cerr << "Error:  Unable to open temporary file \"" << m_filename << "\" for write." << endl
+	       << endl;
+	  return false;
+	}
+      // The record count is filled in by finish().
+      m_ofs.write(HOTSPOT2_INTERMEDIATE_MAGIC, HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH);
+      writeFixedWidth(m_ofs, 0, HOTSPOT2_INTERMEDIATE_HEADER_SIZE - HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH);
+    }
+  const size_t numBytes(pptr() - pbase());
+  m_ofs.write(pbase(), numBytes);
+  if (!m_ofs)
+    {
+      cerr << "Error:  Failed to write to temporary file \"" << m_filename << "\"." << endl
+	   << endl;
+      return false;
+    }
+  m_numBytesInFile += numBytes;
+  resetPutArea(0);
+  return true;
+}
+
+SpillBuffer::int_type SpillBuffer::overflow(int_type c)
+{
+  if (traits_type::eq_int_type(c, traits_type::eof()))
+    return traits_type::not_eof(c);
+  if (m_failed)
+    return traits_type::eof();
+
+  const size_t numBytesUsed(pptr() - pbase());
+  if (!spilled() && m_mem.size() < m_budget)
+    {
+      m_mem.resize(min(max(2 * m_mem.size(), static_cast<size_t>(1 << 20)), m_budget));
+      resetPutArea(numBytesUsed);
+    }
+  else if (!writeToFile())
+    {
+      m_failed = true;
+      return traits_type::eof();
+    }
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+bool SpillBuffer::finish(void)
+{
+  if (m_failed)
+    return false;
+  if (!spilled())
+    {
+      m_numBytesInMemory = pptr() - pbase();
+      return true;
+    }
+  if (!writeToFile())
+    return false;
+  m_ofs.seekp(HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH);
+  writeFixedWidth(m_ofs, m_numBytesInFile / HOTSPOT2_INTERMEDIATE_RECORD_SIZE,
+		  HOTSPOT2_INTERMEDIATE_HEADER_SIZE - HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH);
+  m_ofs.close();
+  if (!m_ofs)
+    {
+      cerr << "Error:  Failed to write to temporary file \"" << m_filename << "\"." << endl
+	   << endl;
+      return false;
+    }
+  vector<char>().swap(m_mem); // release the write buffer before the file gets mapped into memory
+  setp(NULL, NULL);
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+
+  // Option defaults
+  Part1Options part1; // the options shared with hotspot2_part1
+  long double fdr_threshold = 1.00;
+  int write_pvals = 0;
+  long memory_budget = 1024; // MB
+  int print_help = 0;
+  int print_version = 0;
+  string outfilename = "";
+
+  // Long-opt definitions
+  vector<struct option> long_options;
+  part1.addLongOptions(long_options);
+  static const struct option own_long_options[] = {
+    { "output", required_argument, 0, 'o' },
+    { "fdr_threshold", required_argument, 0, 'f' },
+    { "write_pvals", no_argument, &write_pvals, 1 },
+    { "memory_budget", required_argument, 0, 'M' },
+    { "help", no_argument, &print_help, 1 },
+    { "version", no_argument, &print_version, 1 },
+    { 0, 0, 0, 0 }
+  };
+  long_options.insert(long_options.end(), own_long_options,
+		      own_long_options + sizeof(own_long_options) / sizeof(own_long_options[0]));
+  const string short_options(string(Part1Options::shortOptions()) + "f:M:o:hvV");
+
+  // Parse options
+  char c;
+  while ((c = getopt_long(argc, argv, short_options.c_str(), &long_options[0], NULL)) != -1)
+    {
+      if (part1.parse(c, optarg, print_help))
+	continue;
+      switch (c)
+        {
+        case 'o':
+          outfilename = optarg;
+          break;
+        case 'f':
+          {
+            istringstream iss(optarg); // allows scientific notation
+            if (!(iss >> fdr_threshold) || !(iss >> ws).eof())
+              {
+                cerr << "Error:  Invalid FDR threshold \"" << optarg << "\"." << endl
+                     << endl;
+                print_help = 1;
+              }
+          }
+          break;
+        case 'M':
+          memory_budget = atol(optarg);
+          break;
+	case 'h':
+          print_help = 1;
+          break;
+        case 'v':
+        case 'V':
+          print_version = 1;
+          break;
+        // no short option needed for --write_pvals
+        case 0:
+          // long option received, do nothing
+          break;
+        default:
+          print_help = 1;
+        }
+    }
+
+  if (!print_help && !print_version && !part1.validate(true))
+    print_help = 1;
+  if (!print_help && !print_version && memory_budget < 1)
+    {
+      cerr << "Error:  The memory budget must be at least 1 MB."
+	   << endl
+	   << endl;
+      print_help = 1;
+    }
+
+  // Print usage and exit if necessary
+  if (print_help)
+    {
+      cerr << "Usage:  " << argv[0] << " [options] < in.cutcounts.bed > out.FDR.bed\n"
+           << "\n"
+           << "Runs hotspot2_part1 and hotspot2_part2 in a single process.\n"
+           << "\n"
+           << "Options: \n";
+      Part1Options::writeHelp(cerr);
+      cerr << "  --write_pvals                  Output P-values in column 6 (P-values are not output by default)\n"
+           << "  -f, --fdr_threshold=THRESHOLD  Do not output sites with FDR > THRESHOLD (1.00)\n"
+           << "  -M, --memory_budget=MB         Hold up to MB megabytes of site ranges in memory before\n"
+           << "                                 spilling them to a temporary file in $TMPDIR (1024)\n"
+           << "  -o, --output=FILE              A file to write output to (STDOUT)\n"
+           << "  -v, --version                  Print the version information and exit\n"
+           << "  -h, --help                     Display this helpful help\n"
+           << "\n"
+           << " output (sent to stdout) will be a .bed5 file with FDR in field 5\n"
+           << "\tor, if --write_pvals is specified, a .bed6 file with P-values appended in field 6\n"
+           << " input (received from stdin) requires IDs in field 4 and counts in field 5.\n"
+           << " --stats covers part 1, i.e., the computation of the P-values.\n"
+           << endl
+           << endl;
+      return -1;
+    }
+
+  if (print_version)
+    {
+      cout << argv[0] << " version " << hotspot2_VERSION_MAJOR
+           << '.' << hotspot2_VERSION_MINOR << endl;
+      return 0;
+    }
+
+  ios_base::sync_with_stdio(false); // calling this static method in this way turns off checks, speeds up I/O
+
+  if (!outfilename.empty() && outfilename != "-")
+    {
+      if (freopen(outfilename.c_str(), "w", stdout) == NULL)
+        {
+          cerr << "Error: Couldn't open output file " << outfilename << " for writing" << endl;
+          return 1;
+        }
+    }
+
+  // Part 1:  P-values, with the site ranges going to the spill buffer.
+  SpillBuffer spill(static_cast<size_t>(memory_budget) << 20);
+  ostream osSpill(&spill);
+  if (!part1.start())
+    return -1;
+  ChromosomeTable chroms;
+  ScoreHistogram hist;
+  if (!part1.process(part1.checkpointSettings(true), chroms, osSpill, hist, true))
+    return -1;
+  if (!osSpill.flush() || !spill.finish())
+    return -1;
+  if (!part1.finish(chroms))
+    return -1;
+
+  // Part 2:  FDRs, streamed from the spill buffer.
+  vector<long double> FDRtable;
+  {
+    vector<long> PvalHistogram; // released once the FDR table has been built
+    hist.addTo(PvalHistogram);
+    if (!buildFDRtable(PvalHistogram, FDRtable))
+      return -1;
+  }
+  map<int, string*> IntToChromNameMap;
+  chroms.getIntToChromNameMap(IntToChromNameMap);
+
+  BinarySiteReader reader;
+  if (spill.spilled())
+    {
+      if (!reader.open(spill.filename()))
+	return -1;
+    }
+  else
+    reader.attach(spill.records(), spill.numRecordsInMemory());
+  if (!streamAndProcessInput(reader, IntToChromNameMap, FDRtable, fdr_threshold, write_pvals ? true : false))
+    return -1;
+
+  if (!part1.checkpointDir.empty())
+    {
+      // The checkpoint is only removed once all of the output is known to have been written.
+      if (!cout.flush())
+	{
+	  cerr << "Error:  Failed to write the output; the checkpoint in \"" << part1.checkpointDir << "\" was kept." << endl
+	       << endl;
+	  return -1;
+	}
+      removeCheckpoint(part1.checkpointDir);
+    }
+
+  return 0;
+}
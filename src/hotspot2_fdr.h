@@ -0,0 +1,359 @@
+// Benjamini-Hochberg FDRs for the site ranges written by hotspot2_part1, as used by hotspot2_part2
+// and hotspot2_engine:  a histogram of scaled -log10(P) values is turned into an FDR table indexed by score,
+// and site ranges are then streamed through it, in genomic order, and written out as BED.
+//
+#ifndef HOTSPOT2_FDR_H
+#define HOTSPOT2_FDR_H
+
+#include "hotspot2_intermediate.h"
+#include "hotspot2_tsv.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h> // for open()
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/mman.h> // for mmap()
+#include <sys/stat.h> // for fstat()
+#include <unistd.h> // for close()
+#include <vector>
+
+using namespace std;
+
+struct SiteRangeData {
+  int negLog10P_scaled;
+  int begPos;
+  int width;
+  int chromID;
+};
+
+// Scores (scaled -log10(P) values) are nonnegative integers, bounded by hotspot2_part1's MAX_VALUE,
+// so the histogram of them is a flat array indexed by score, sized to the largest score seen.
+// Histograms of several files of P-values can be combined by adding them elementwise.
+bool readPvalueHistogram(istream& ifs, vector<long>& hist);
+bool readPvalueHistogram(istream& ifs, vector<long>& hist)
+{
+  LineReader lines(ifs);
+  char* fields[2];
+  int negLog10P_scaled;
+  long numOccs; // for score 0, this can exceed INT_MAX on a whole genome
+  int linenum(0), numFields;
+
+  while (lines.next())
+    {
+      linenum++;
+      numFields = splitFields(lines.line(), lines.length(), '\t', fields, 2);
+      if (numFields < 2 || !*fields[0])
+	{
+	  cerr << "Error:  Failed to find field " << (!*fields[0] ? 1 : 2)
+	       << " on line " << linenum << " of the file of P-values."
+	       << endl << endl;
+	  return false;
+	}
+      negLog10P_scaled = parseInt(fields[0]);
+      numOccs = parseLong(fields[1]);
+      if (negLog10P_scaled < 0)
+	{
+	  cerr << "Error:  Negative scaled -log10(P) value " << negLog10P_scaled
+	       << " found on line " << linenum << " of the file of P-values."
+	       << endl << endl;
+	  return false;
+	}
+      if (static_cast<unsigned long>(negLog10P_scaled) >= hist.size())
+	hist.resize(negLog10P_scaled + 1, 0);
+      hist[negLog10P_scaled] += numOccs;
+    }
+
+  return true;
+}
+
+// Benjamini-Hochberg FDRs, indexed directly by score.
+// Scores that don't occur in hist, and scores below the point where the FDR exceeds 0.999, get FDR = 1.
+bool buildFDRtable(const vector<long>& hist, vector<long double>& fdr);
+bool buildFDRtable(const vector<long>& hist, vector<long double>& fdr)
+{
+  long numPvalues(0);
+  int minScore(-1);
+
+  for (unsigned long score = 0; score < hist.size(); score++)
+    {
+      if (hist[score] != 0 && -1 == minScore)
+	minScore = static_cast<int>(score);
+      numPvalues += hist[score];
+    }
+  if (0 == numPvalues)
+    {
+      cerr << "Error:  Received an empty file of P-values." << endl << endl;
+      return false;
+    }
+
+  fdr.assign(hist.size(), 1.);
+
+  long numThisExtremeOrMoreExtreme(0);
+  const long double N(static_cast<double>(numPvalues));
+  long double prevFDR(-1.), FDR;
+  // The smallest score always gets FDR = 1.
+  for (int score = static_cast<int>(hist.size()) - 1; score > minScore; score--)
+    {
+      if (0 == hist[score])
+	continue;
+      numThisExtremeOrMoreExtreme += hist[score];
+      FDR = pow(10., -score/CHANGE_OF_SCALE) * N / static_cast<long double>(numThisExtremeOrMoreExtreme);
+      //      if (FDR < numeric_limits<double>::min())
+      //	FDR = numeric_limits<double>::min();
+      if (FDR < prevFDR)
+	FDR = prevFDR;
+      if (FDR > 0.999)
+	break;
+      fdr[score] = FDR;
+      prevFDR = FDR;
+    }
+
+  return true;
+}
+
+bool buildIntToChromNameMap(istream& infile, map<int, string*>& mapOut);
+bool buildIntToChromNameMap(istream& infile, map<int, string*>& mapOut)
+{
+  LineReader lines(infile);
+  char* fields[2];
+  int ID;
+  map<int, string*>::const_iterator it;
+  int linenum(0), numFields;
+
+  while (lines.next())
+    {
+      linenum++;
+      numFields = splitFields(lines.line(), lines.length(), '\t', fields, 2);
+      if (numFields < 2 || !*fields[0] || !*fields[1])
+	{
+	  cerr << "Error:  Failed to find field " << (!*fields[0] ? 1 : 2)
+	       << " on line " << linenum
+	       << " of the number-to-chromosomeName mapping file."
+	       << endl << endl;
+	  return false;
+	}
+      ID = parseInt(fields[0]);
+      it = mapOut.find(ID);
+      if (it != mapOut.end())
+	{
+	  cerr << "Error:  Multiple entries found in the number-to-chromosomeName mapping file\n"
+	       << "with value " << ID << " in the first column; each mapping must be unique."
+	       << endl << endl;
+	  return false;
+	}
+      mapOut[ID] = new string(fields[1]);
+    }
+  
+  return true;
+}
+
+// Reads the text lines "chromID \t beg \t width \t score" written by hotspot2_part1, one at a time.
+class TextSiteReader {
+public:
+  TextSiteReader(istream& is) : m_lines(is), m_linenum(0) {};
+  bool next(SiteRangeData& site); // returns false at end of input, or on error (see failed())
+  bool failed(void) const { return m_failed; };
+  long numRead(void) const { return m_linenum; };
+
+private:
+  TextSiteReader(const TextSiteReader&); // deny use of the copy constructor
+  LineReader m_lines;
+  long m_linenum;
+  bool m_failed;
+};
+
+bool TextSiteReader::next(SiteRangeData& site)
+{
+  char* fields[4];
+  int numFields, fieldnum;
+
+  m_failed = false;
+  if (!m_lines.next())
+    return false;
+  m_linenum++;
+  numFields = splitFields(m_lines.line(), m_lines.length(), '\t', fields, 4);
+  for (fieldnum = 1; fieldnum <= 4; fieldnum++)
+    {
+      if (fieldnum > numFields || !*fields[fieldnum - 1])
+	{
+	  cerr << "Error:  Failed to find required field " << fieldnum
+	       << " on line " << m_linenum << " of the file of location and P-value data."
+	       << endl << endl;
+	  m_failed = true;
+	  return false;
+	}
+    }
+  site.chromID = parseInt(fields[0]);
+  site.begPos = parseInt(fields[1]);
+  site.width = parseInt(fields[2]);
+  site.negLog10P_scaled = parseInt(fields[3]);
+
+  return true;
+}
+
+// Reads the binary intermediate file written by hotspot2_part1 --output-format=bin
+// (see hotspot2_intermediate.h), mapped into memory.  The record count comes from the file's header.
+class BinarySiteReader {
+public:
+  BinarySiteReader() : m_addr(MAP_FAILED), m_numBytes(0), m_p(NULL), m_numRecords(0), m_numRead(0) {};
+  ~BinarySiteReader();
+  bool open(const string& filename);
+  void attach(const char* records, const unsigned long& numRecords);
+  bool next(SiteRangeData& site);
+  bool failed(void) const { return false; };
+  long numRead(void) const { return m_numRead; };
+  unsigned long numRecords(void) const { return m_numRecords; };
+
+private:
+  BinarySiteReader(const BinarySiteReader&); // deny use of the copy constructor
+  void* m_addr;
+  size_t m_numBytes;
+  const unsigned char* m_p;
+  unsigned long m_numRecords;
+  long m_numRead;
+};
+
+BinarySiteReader::~BinarySiteReader()
+{
+  if (m_addr != MAP_FAILED)
+    munmap(m_addr, m_numBytes);
+}
+
+bool BinarySiteReader::open(const string& filename)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      cerr << "Error:  Unable to open file \"" << filename << "\" for read." << endl << endl;
+      return false;
+    }
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || sb.st_size < HOTSPOT2_INTERMEDIATE_HEADER_SIZE)
+    {
+      cerr << "Error:  File \"" << filename << "\" is too small to be a hotspot2_part1 binary output file."
+	   << endl << endl;
+      close(fd);
+      return false;
+    }
+  m_numBytes = sb.st_size;
+  m_addr = mmap(NULL, m_numBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED == m_addr)
+    {
+      cerr << "Error:  Unable to map file \"" << filename << "\" into memory." << endl << endl;
+      return false;
+    }
+  madvise(m_addr, m_numBytes, MADV_SEQUENTIAL);
+  m_p = static_cast<const unsigned char*>(m_addr);
+
+  if (memcmp(m_p, HOTSPOT2_INTERMEDIATE_MAGIC, HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH) != 0)
+    {
+      cerr << "Error:  File \"" << filename << "\" is not a hotspot2_part1 binary output file." << endl << endl;
+      return false;
+    }
+  m_numRecords = decodeLE64(m_p + HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH);
+  if (m_numBytes - HOTSPOT2_INTERMEDIATE_HEADER_SIZE != m_numRecords * HOTSPOT2_INTERMEDIATE_RECORD_SIZE)
+    {
+      cerr << "Error:  The header of \"" << filename << "\" specifies " << m_numRecords
+	   << " records, but the file contains "
+	   << (m_numBytes - HOTSPOT2_INTERMEDIATE_HEADER_SIZE) / HOTSPOT2_INTERMEDIATE_RECORD_SIZE
+	   << " (and " << (m_numBytes - HOTSPOT2_INTERMEDIATE_HEADER_SIZE) % HOTSPOT2_INTERMEDIATE_RECORD_SIZE
+	   << " trailing bytes)." << endl << endl;
+      return false;
+    }
+  m_p += HOTSPOT2_INTERMEDIATE_HEADER_SIZE;
+
+  return true;
+}
+
+// Read records that are already in memory (without the header), instead of a file.
+void BinarySiteReader::attach(const char* records, const unsigned long& numRecords)
+{
+  m_p = reinterpret_cast<const unsigned char*>(records);
+  m_numRecords = numRecords;
+  m_numRead = 0;
+}
+
+inline bool BinarySiteReader::next(SiteRangeData& site)
+{
+  if (static_cast<unsigned long>(m_numRead) == m_numRecords)
+    return false;
+  decodeIntermediateRecord(m_p, site.chromID, site.begPos, site.width, site.negLog10P_scaled);
+  m_p += HOTSPOT2_INTERMEDIATE_RECORD_SIZE;
+  m_numRead++;
+  return true;
+}
+
+// The FDR of a site depends only on its scaled -log10(P), and hotspot2_part1 writes sites in genomic order,
+// so each site can be written as soon as it's read, with its FDR looked up in FDRtable.
+// Nothing is buffered or sorted.
+template <class SiteReader>
+bool streamAndProcessInput(SiteReader& reader, const map<int, string*>& intToChromNameMap,
+			   const vector<long double>& FDRtable,
+			   const long double& FDRthreshold, const bool& writePvals)
+{
+  SiteRangeData site;
+  long double FDR;
+  int prevChromID(-1), prevBegPos(-1);
+  string *prevChromString(NULL);
+
+  while (reader.next(site))
+    {
+      if (site.negLog10P_scaled < 0 || static_cast<unsigned long>(site.negLog10P_scaled) >= FDRtable.size())
+	{
+	  cerr << "Error:  Entry " << reader.numRead() << " of the file of location and P-value data\n"
+	       << "has scaled -log10(P) = " << site.negLog10P_scaled << ", but the largest value\n"
+	       << "in the file of scaled -log10(P) values is " << FDRtable.size() - 1 << '.'
+	       << endl << endl;
+	  return false;
+	}
+      FDR = FDRtable[site.negLog10P_scaled];
+
+      // Even though the map is tiny, perform as few map lookups as possible.
+      if (site.chromID != prevChromID)
+	{
+	  if (site.chromID < prevChromID)
+	    {
+	      cerr << "Error:  Entry " << reader.numRead() << " of the file of location and P-value data\n"
+		   << "is out of genomic order (chromosome " << site.chromID << " follows " << prevChromID << ")."
+		   << endl << endl;
+	      return false;
+	    }
+	  map<int, string*>::const_iterator it = intToChromNameMap.find(site.chromID);
+	  if (intToChromNameMap.end() == it)
+	    {
+	      cerr << "Error:  Entry " << reader.numRead() << " of the file of location and P-value data\n"
+		   << "has chromosome " << site.chromID << ", which is not in the file of chromosome names."
+		   << endl << endl;
+	      return false;
+	    }
+	  prevChromString = it->second;
+	  prevChromID = site.chromID;
+	}
+      else if (site.begPos <= prevBegPos)
+	{
+	  cerr << "Error:  Entry " << reader.numRead() << " of the file of location and P-value data\n"
+	       << "is out of genomic order (position " << site.begPos << " follows " << prevBegPos << ")."
+	       << endl << endl;
+	  return false;
+	}
+      prevBegPos = site.begPos;
+
+      if (FDR <= FDRthreshold)
+	{
+	  cout << *prevChromString << '\t'
+	       << site.begPos << '\t'
+	       << site.begPos + site.width << "\ti\t"
+	       << FDR;
+	  if (writePvals)
+	    cout << '\t' << pow(10., -site.negLog10P_scaled/CHANGE_OF_SCALE);
+	  cout << '\n';
+	}
+    }
+
+  return !reader.failed();
+}
+
+#endif // HOTSPOT2_FDR_H
@@ -0,0 +1,551 @@
+// Readers for the input of hotspot2_part1 and hotspot2_engine:  BED5 lines of tallied cut counts,
+// the binary format described in hotspot2_binary_input.h, or center sites and cut counts
+// that get tallied on the fly.  Each reader delivers the input one range of sites at a time.
+//
+#ifndef HOTSPOT2_INPUT_H
+#define HOTSPOT2_INPUT_H
+
+#include "hotspot2_binary_input.h"
+#include "hotspot2_tsv.h"
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Parse a line of input (chrom, beg, end, ID, count; any further fields are ignored)
+// that has been read by a LineReader.  The chromosome name is left in place, null-terminated, at the start of buf,
+// and its length is returned in chromLength.
+bool parseLine(char* buf, const size_t& length, const long& linenum, size_t& chromLength, long& start, long& end, int& count);
+bool parseLine(char* buf, const size_t& length, const long& linenum, size_t& chromLength, long& start, long& end, int& count)
+{
+  char* fields[5];
+  const int numFields = splitFields(buf, length, '\t', fields, 5);
+
+  if (numFields < 5 || !*fields[0])
+    {
+      cerr << "Error:  Missing required field " << (!*fields[0] ? 1 : numFields + 1)
+           << " on line " << linenum << "." << endl
+           << endl;
+      return false;
+    }
+  chromLength = fields[1] - fields[0] - 1;
+  start = parseLong(fields[1]);
+  end = parseLong(fields[2]);
+  count = parseInt(fields[4]);
+
+  return true;
+}
+
+// Reads the input one range of sites at a time,
+// either as BED5 text or in the binary format described in hotspot2_binary_input.h.
+// A range is a BED5 line, or a run in the binary format.
+class RangeReader {
+public:
+  // Where the reader is, just before a range; used to resume reading from a segment's first range.
+  struct Position {
+    string chromName;
+    long prevEnd; // end of the previous run in the binary block, used to decode the next one
+    long linenum; // number of ranges read before this one
+    unsigned long numRecordsLeftInBlock;
+  };
+  RangeReader(istream& is, const bool& binary);
+  bool readHeader(void);
+  bool next(void); // returns false at the end of input and upon error; see failed()
+  void resume(const Position& pos);
+  bool failed(void) const { return m_failed; };
+  bool chromChanged(void) const { return m_chromChanged; };
+  const string& chromName(void) const { return m_chromName; };
+  const long& start(void) const { return m_start; };
+  const long& end(void) const { return m_end; };
+  const int& count(void) const { return m_count; };
+  const long& linenum(void) const { return m_linenum; };
+  const Position& positionOfRange(void) const { return m_posOfRange; }; // position just before the current range
+  const streamoff& offsetOfRange(void) const { return m_offsetOfRange; }; // offset of the current range, relative to the start or resumption point
+  const streamoff& numBytesRead(void) const { return m_numBytesRead; };
+
+private:
+  RangeReader(void); // require use of the constructor with 2 arguments
+  RangeReader(const RangeReader&); // ditto
+  bool nextLine(void);
+  bool nextRecord(void);
+  istream& m_is;
+  LineReader m_lines; // used for text input
+  bool m_binary;
+  bool m_failed;
+  bool m_chromChanged;
+  bool m_haveChrom;
+  string m_chromName;
+  long m_start;
+  long m_end;
+  int m_count;
+  long m_linenum;
+  long m_prevEnd;
+  unsigned long m_numRecordsLeftInBlock;
+  Position m_posOfRange;
+  streamoff m_offsetOfRange;
+  streamoff m_numBytesRead;
+};
+
+RangeReader::RangeReader(istream& is, const bool& binary) : m_is(is), m_lines(is)
+{
+  m_binary = binary;
+  m_failed = m_chromChanged = m_haveChrom = false;
+  m_start = m_end = m_prevEnd = -1;
+  m_count = -1;
+  m_linenum = 0;
+  m_numRecordsLeftInBlock = 0;
+  m_posOfRange.prevEnd = -1;
+  m_posOfRange.linenum = 0;
+  m_posOfRange.numRecordsLeftInBlock = 0; // for text input, these only ever get linenum set
+  m_offsetOfRange = m_numBytesRead = 0;
+}
+
+// Checks the magic string at the start of binary input; a no-op for text.
+bool RangeReader::readHeader(void)
+{
+  if (!m_binary)
+    return true;
+  char magic[HOTSPOT2_BIN_MAGIC_LENGTH];
+  if (m_is.rdbuf()->sgetn(magic, HOTSPOT2_BIN_MAGIC_LENGTH) != HOTSPOT2_BIN_MAGIC_LENGTH
+      || strncmp(magic, HOTSPOT2_BIN_MAGIC, HOTSPOT2_BIN_MAGIC_LENGTH) != 0)
+    {
+      cerr << "Error:  The input does not begin with \"" << HOTSPOT2_BIN_MAGIC
+           << "\"; it is not in hotspot2's binary input format." << endl
+           << endl;
+      m_failed = true;
+      return false;
+    }
+  m_numBytesRead = HOTSPOT2_BIN_MAGIC_LENGTH;
+  return true;
+}
+
+// Continue reading from a range previously reported by positionOfRange(),
+// after the caller has seeked the stream to it.
+void RangeReader::resume(const Position& pos)
+{
+  m_chromName = pos.chromName;
+  m_haveChrom = true;
+  m_prevEnd = pos.prevEnd;
+  m_linenum = pos.linenum;
+  m_numRecordsLeftInBlock = pos.numRecordsLeftInBlock;
+  m_offsetOfRange = m_numBytesRead = 0;
+  m_lines.reset();
+}
+
+bool RangeReader::next(void)
+{
+  m_chromChanged = false;
+  return m_binary ? nextRecord() : nextLine();
+}
+
+bool RangeReader::nextLine(void)
+{
+  m_posOfRange.linenum = m_linenum;
+  m_offsetOfRange = m_numBytesRead;
+  if (!m_lines.next())
+    return false;
+  m_linenum++;
+  m_numBytesRead = m_lines.numBytesRead();
+  size_t chromLength;
+  if (!parseLine(m_lines.line(), m_lines.length(), m_linenum, chromLength, m_start, m_end, m_count))
+    {
+      m_failed = true;
+      return false;
+    }
+  if (!m_haveChrom || !sameName(m_chromName, m_lines.line(), chromLength))
+    {
+      m_chromName.assign(m_lines.line(), chromLength);
+      m_chromChanged = m_haveChrom = true;
+    }
+  return true;
+}
+
+bool RangeReader::nextRecord(void)
+{
+  streambuf* sb = m_is.rdbuf();
+  unsigned long val, delta, length, count;
+
+  while (0 == m_numRecordsLeftInBlock)
+    {
+      // Read the next block's header.
+      if (sb->sgetc() == char_traits<char>::eof())
+        return false; // normal end of input
+      if (!readFixedWidth(sb, val, 4))
+        goto Truncated;
+      if (val > HOTSPOT2_BIN_MAX_CHROM_NAME_LENGTH)
+        {
+          cerr << "Error:  The binary input is corrupt, after record " << m_linenum
+               << ":  a block claims a chromosome name of " << val << " bytes (the maximum is "
+               << HOTSPOT2_BIN_MAX_CHROM_NAME_LENGTH << ")." << endl
+               << endl;
+          m_failed = true;
+          return false;
+        }
+      string name(val, '\0');
+      if (static_cast<unsigned long>(sb->sgetn(&name[0], val)) != val
+          || !readFixedWidth(sb, m_numRecordsLeftInBlock, 8)
+          || !readFixedWidth(sb, val, 8)) // the number of bytes of record data, only needed to skip the block
+        goto Truncated;
+      m_numBytesRead += 4 + name.size() + 8 + 8;
+      if (!m_haveChrom || m_chromName != name)
+        {
+          m_chromName = name;
+          m_chromChanged = m_haveChrom = true;
+        }
+      m_prevEnd = 0;
+    }
+
+  m_posOfRange.chromName = m_chromName;
+  m_posOfRange.prevEnd = m_prevEnd;
+  m_posOfRange.linenum = m_linenum;
+  m_posOfRange.numRecordsLeftInBlock = m_numRecordsLeftInBlock;
+  m_offsetOfRange = m_numBytesRead;
+  if (!readVarint(sb, delta, m_numBytesRead)
+      || !readVarint(sb, length, m_numBytesRead)
+      || !readVarint(sb, count, m_numBytesRead))
+    goto Truncated;
+  m_linenum++;
+  m_numRecordsLeftInBlock--;
+  m_start = m_prevEnd + static_cast<long>(delta);
+  m_end = m_start + static_cast<long>(length);
+  m_count = static_cast<int>(count);
+  m_prevEnd = m_end;
+  return true;
+
+Truncated:
+  cerr << "Error:  The binary input is truncated or corrupt, after record " << m_linenum << "." << endl
+       << endl;
+  m_failed = true;
+  return false;
+}
+
+// Reads several samples' counts at the same sites, for processing them in one pass:
+// either one stream of BED lines with a count per sample (chrom, beg, end, ID, count_1, ..., count_K),
+// or one stream of BED5 lines per sample, whose lines must correspond (same chrom, beg and end).
+// The interface mirrors that of RangeReader, with count(k) giving sample k's count.
+class MultiSampleReader {
+public:
+  MultiSampleReader(istream& is, const int& numSamples);
+  MultiSampleReader(const vector<istream*>& streams);
+  ~MultiSampleReader(void);
+  bool next(void); // returns false at the end of input and upon error; see failed()
+  bool failed(void) const { return m_failed; };
+  bool chromChanged(void) const { return m_chromChanged; };
+  const string& chromName(void) const { return m_chromName; };
+  const long& start(void) const { return m_start; };
+  const long& end(void) const { return m_end; };
+  const int& count(const int& k) const { return m_counts[k]; };
+  int numSamples(void) const { return static_cast<int>(m_counts.size()); };
+
+private:
+  MultiSampleReader(void); // require use of one of the constructors above
+  MultiSampleReader(const MultiSampleReader&); // ditto
+  bool nextLineWithCounts(void);
+  bool nextAlignedLines(void);
+  vector<LineReader*> m_lines; // one stream with all of the counts, or one per sample
+  vector<char*> m_fields;
+  bool m_failed;
+  bool m_chromChanged;
+  bool m_haveChrom;
+  string m_chromName;
+  long m_start;
+  long m_end;
+  vector<int> m_counts;
+  long m_linenum;
+};
+
+MultiSampleReader::MultiSampleReader(istream& is, const int& numSamples)
+  : m_fields(4 + numSamples), m_counts(numSamples, -1)
+{
+  m_lines.push_back(new LineReader(is));
+  m_failed = m_chromChanged = m_haveChrom = false;
+  m_start = m_end = -1;
+  m_linenum = 0;
+}
+
+MultiSampleReader::MultiSampleReader(const vector<istream*>& streams)
+  : m_fields(5), m_counts(streams.size(), -1)
+{
+  for (unsigned int k = 0; k < streams.size(); k++)
+    m_lines.push_back(new LineReader(*streams[k]));
+  m_failed = m_chromChanged = m_haveChrom = false;
+  m_start = m_end = -1;
+  m_linenum = 0;
+}
+
+MultiSampleReader::~MultiSampleReader(void)
+{
+  for (vector<LineReader*>::iterator it = m_lines.begin(); it != m_lines.end(); it++)
+    delete *it;
+}
+
+bool MultiSampleReader::next(void)
+{
+  m_chromChanged = false;
+  return (1 == m_lines.size()) ? nextLineWithCounts() : nextAlignedLines();
+}
+
+bool MultiSampleReader::nextLineWithCounts(void)
+{
+  LineReader& lines = *m_lines[0];
+  if (!lines.next())
+    return false;
+  m_linenum++;
+  const int numFields(static_cast<int>(m_fields.size()));
+  const int numFound(splitFields(lines.line(), lines.length(), '\t', &m_fields[0], numFields));
+  if (numFound < numFields || !*m_fields[0])
+    {
+      cerr << "Error:  Missing required field " << (!*m_fields[0] ? 1 : numFound + 1)
+           << " on line " << m_linenum << " (chrom, beg, end, ID, and a count for each of the "
+           << m_counts.size() << " samples are required)." << endl
+           << endl;
+      m_failed = true;
+      return false;
+    }
+  const size_t chromLength(m_fields[1] - m_fields[0] - 1);
+  if (!m_haveChrom || !sameName(m_chromName, m_fields[0], chromLength))
+    {
+      m_chromName.assign(m_fields[0], chromLength);
+      m_chromChanged = m_haveChrom = true;
+    }
+  m_start = parseLong(m_fields[1]);
+  m_end = parseLong(m_fields[2]);
+  for (unsigned int k = 0; k < m_counts.size(); k++)
+    m_counts[k] = parseInt(m_fields[4 + k]);
+  return true;
+}
+
+bool MultiSampleReader::nextAlignedLines(void)
+{
+  m_linenum++;
+  for (unsigned int k = 0; k < m_lines.size(); k++)
+    {
+      LineReader& lines = *m_lines[k];
+      if (!lines.next())
+        {
+          if (k != 0)
+            {
+              cerr << "Error:  Input " << k + 1 << " ends at line " << m_linenum - 1
+                   << ", before input 1 does; the samples' inputs must list the same sites." << endl
+                   << endl;
+              m_failed = true;
+            }
+          else
+            {
+              // Input 1 has ended; so must all of the others.
+              for (unsigned int j = 1; j < m_lines.size(); j++)
+                {
+                  if (m_lines[j]->next())
+                    {
+                      cerr << "Error:  Input " << j + 1 << " continues past line " << m_linenum - 1
+                           << ", where input 1 ends; the samples' inputs must list the same sites." << endl
+                           << endl;
+                      m_failed = true;
+                      break;
+                    }
+                }
+            }
+          return false;
+        }
+      size_t chromLength;
+      long start, end;
+      if (!parseLine(lines.line(), lines.length(), m_linenum, chromLength, start, end, m_counts[k]))
+        {
+          cerr << "(The line is in input " << k + 1 << ".)" << endl
+               << endl;
+          m_failed = true;
+          return false;
+        }
+      if (0 == k)
+        {
+          if (!m_haveChrom || !sameName(m_chromName, lines.line(), chromLength))
+            {
+              m_chromName.assign(lines.line(), chromLength);
+              m_chromChanged = m_haveChrom = true;
+            }
+          m_start = start;
+          m_end = end;
+        }
+      else if (start != m_start || end != m_end || !sameName(m_chromName, lines.line(), chromLength))
+        {
+          cerr << "Error:  Line " << m_linenum << " of input " << k + 1 << " (" << lines.line() << ':' << start << '-' << end
+               << ") doesn't list the same site(s) as line " << m_linenum << " of input 1 ("
+               << m_chromName << ':' << m_start << '-' << m_end << ")." << endl
+               << endl;
+          m_failed = true;
+          return false;
+        }
+    }
+  return true;
+}
+
+// Tallies the cut counts within +/- neighborhoodSize bp of each center site,
+// exactly as "bedmap --faster --range N --echo --sum CENTER_SITES CUTCOUNTS" does
+// (with 0 in place of bedmap's NAN), by reading the two sorted BED files itself.
+// The cut counts overlapping the current center site's neighborhood are held in a queue,
+// along with their running sum; each cut count is added once, when the neighborhood's
+// right edge passes it, and subtracted once, when the left edge passes it.
+// Abutting center sites with equal tallies are reported together as one range.
+// The interface mirrors that of RangeReader.
+class NeighborhoodTallier {
+public:
+  NeighborhoodTallier(istream& isCenters, istream& isCuts, const int& neighborhoodSize);
+  bool next(void); // returns false at the end of input and upon error; see failed()
+  bool failed(void) const { return m_failed; };
+  bool chromChanged(void) const { return m_chromChanged; };
+  const string& chromName(void) const { return m_chromName; };
+  const long& start(void) const { return m_start; };
+  const long& end(void) const { return m_end; };
+  const int& count(void) const { return m_count; };
+
+private:
+  NeighborhoodTallier(void); // require use of the constructor with 3 arguments
+  NeighborhoodTallier(const NeighborhoodTallier&); // ditto
+  struct CutCount {
+    long beg;
+    long end;
+    long count;
+  };
+  bool readCenter(void);
+  bool readCut(void);
+  LineReader m_centerLines;
+  LineReader m_cutLines;
+  long m_neighborhoodSize;
+  bool m_failed;
+  bool m_chromChanged;
+  bool m_centersExhausted;
+  // the range to be reported by the next call to next()
+  string m_chromName;
+  long m_start;
+  long m_end;
+  int m_count;
+  // the most recently read center site, and its tally
+  string m_centerChrom;
+  long m_centerBeg;
+  long m_centerEnd;
+  long m_centerTally;
+  long m_centerLinenum;
+  // the next cut count not yet added to m_cutsInNeighborhood
+  bool m_haveCut;
+  string m_cutChrom;
+  CutCount m_cut;
+  long m_cutLinenum;
+  deque<CutCount> m_cutsInNeighborhood;
+  long m_sum;
+};
+
+NeighborhoodTallier::NeighborhoodTallier(istream& isCenters, istream& isCuts, const int& neighborhoodSize)
+  : m_centerLines(isCenters), m_cutLines(isCuts)
+{
+  m_neighborhoodSize = neighborhoodSize;
+  m_failed = m_chromChanged = m_centersExhausted = m_haveCut = false;
+  m_start = m_end = m_centerBeg = m_centerEnd = -1;
+  m_count = -1;
+  m_centerTally = m_sum = 0;
+  m_centerLinenum = m_cutLinenum = 0;
+  if (readCut())
+    readCenter(); // prime the first center site and its tally
+}
+
+bool NeighborhoodTallier::next(void)
+{
+  if (m_failed || m_centersExhausted)
+    return false;
+  m_chromChanged = (m_chromName != m_centerChrom || -1 == m_end);
+  m_chromName = m_centerChrom;
+  m_start = m_centerBeg;
+  m_end = m_centerEnd;
+  m_count = static_cast<int>(m_centerTally);
+  while (readCenter())
+    {
+      if (m_centerChrom != m_chromName || m_centerBeg != m_end || m_centerTally != m_count)
+        break;
+      m_end = m_centerEnd;
+    }
+  return !m_failed;
+}
+
+// Reads the next cut count (chrom, beg, end, ID, count) into m_cut.
+// Returns false only upon error; m_haveCut is false at the end of the file.
+bool NeighborhoodTallier::readCut(void)
+{
+  char* fields[5];
+  m_haveCut = false;
+  if (!m_cutLines.next())
+    return true;
+  m_cutLinenum++;
+  if (splitFields(m_cutLines.line(), m_cutLines.length(), '\t', fields, 5) < 5)
+    {
+      cerr << "Error:  Missing required field on line " << m_cutLinenum
+           << " of the file of cut counts (chrom, beg, end, ID, count are required)." << endl
+           << endl;
+      m_failed = true;
+      return false;
+    }
+  const size_t chromLength(fields[1] - fields[0] - 1);
+  if (!sameName(m_cutChrom, fields[0], chromLength))
+    m_cutChrom.assign(fields[0], chromLength);
+  m_cut.beg = parseLong(fields[1]);
+  m_cut.end = parseLong(fields[2]);
+  m_cut.count = parseLong(fields[4]);
+  m_haveCut = true;
+  return true;
+}
+
+// Reads the next center site and tallies the cut counts in its neighborhood.
+// Returns false at the end of the file of center sites and upon error.
+bool NeighborhoodTallier::readCenter(void)
+{
+  char* fields[3];
+  if (!m_centerLines.next())
+    {
+      m_centersExhausted = true;
+      return false;
+    }
+  m_centerLinenum++;
+  if (splitFields(m_centerLines.line(), m_centerLines.length(), '\t', fields, 3) < 3)
+    {
+      cerr << "Error:  Missing required field on line " << m_centerLinenum
+           << " of the file of center sites (chrom, beg, end are required)." << endl
+           << endl;
+      m_failed = true;
+      return false;
+    }
+  const size_t chromLength(fields[1] - fields[0] - 1);
+  if (!sameName(m_centerChrom, fields[0], chromLength))
+    {
+      m_centerChrom.assign(fields[0], chromLength);
+      m_cutsInNeighborhood.clear();
+      m_sum = 0;
+    }
+  m_centerBeg = parseLong(fields[1]);
+  m_centerEnd = parseLong(fields[2]);
+
+  // Skip cut counts on chromosomes that precede this one (in sort-bed order) and have no center sites.
+  while (m_haveCut && strcmp(m_cutChrom.c_str(), m_centerChrom.c_str()) < 0)
+    {
+      if (!readCut())
+        return false;
+    }
+  // Add cut counts that now overlap the neighborhood's right edge...
+  while (m_haveCut && m_cutChrom == m_centerChrom && m_cut.beg < m_centerEnd + m_neighborhoodSize)
+    {
+      m_cutsInNeighborhood.push_back(m_cut);
+      m_sum += m_cut.count;
+      if (!readCut())
+        return false;
+    }
+  // ...and remove those that no longer overlap its left edge.
+  while (!m_cutsInNeighborhood.empty() && m_cutsInNeighborhood.front().end <= m_centerBeg - m_neighborhoodSize)
+    {
+      m_sum -= m_cutsInNeighborhood.front().count;
+      m_cutsInNeighborhood.pop_front();
+    }
+  m_centerTally = m_sum;
+  return true;
+}
+
+#endif // HOTSPOT2_INPUT_H
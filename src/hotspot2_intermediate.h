@@ -0,0 +1,73 @@
+// Binary intermediate format written by hotspot2_part1 (--output-format=bin)
+// and read by hotspot2_part2 (--input-format=bin), in place of the text lines
+// "chromID \t beg \t width \t score" that hotspot2_part1 otherwise writes.
+//
+// The file begins with a 16-byte header:
+//
+//   char[8]   the magic string "HS2INT01"
+//   uint64    number of records that follow
+//
+// Each record is 16 bytes:
+//
+//   uint32    chromosome ID (see hotspot2_part1's --outputChromlist file)
+//   uint32    start of the range of sites
+//   uint32    width of the range, in bp
+//   uint32    scaled -log10(P) shared by all sites in the range
+//
+// All integers are little-endian.  Records appear in the same order as the text lines would.
+// Because the header gives the record count, the reader doesn't need to be told it
+// (cf. hotspot2_part2 --num_entries), and because records are fixed-width,
+// the file can be mapped into memory and decoded in place.
+//
+#ifndef HOTSPOT2_INTERMEDIATE_H
+#define HOTSPOT2_INTERMEDIATE_H
+
+// Scores are scaled -log10(P) values:  floor(-log10(P) * CHANGE_OF_SCALE + 0.5).
+const long double CHANGE_OF_SCALE(1000.);
+
+const char HOTSPOT2_INTERMEDIATE_MAGIC[] = "HS2INT01";
+const int HOTSPOT2_INTERMEDIATE_MAGIC_LENGTH(8);
+const int HOTSPOT2_INTERMEDIATE_HEADER_SIZE(16);
+const int HOTSPOT2_INTERMEDIATE_RECORD_SIZE(16);
+
+inline void encodeLE32(char* buf, const unsigned long& val)
+{
+  buf[0] = static_cast<char>(val & 0xff);
+  buf[1] = static_cast<char>((val >> 8) & 0xff);
+  buf[2] = static_cast<char>((val >> 16) & 0xff);
+  buf[3] = static_cast<char>((val >> 24) & 0xff);
+}
+
+inline unsigned long decodeLE32(const unsigned char* p)
+{
+  return static_cast<unsigned long>(p[0])
+    | (static_cast<unsigned long>(p[1]) << 8)
+    | (static_cast<unsigned long>(p[2]) << 16)
+    | (static_cast<unsigned long>(p[3]) << 24);
+}
+
+inline unsigned long decodeLE64(const unsigned char* p)
+{
+  unsigned long val(0);
+  for (int i = 7; i >= 0; i--)
+    val = (val << 8) | p[i];
+  return val;
+}
+
+inline void encodeIntermediateRecord(char* buf, const int& chromID, const long& begPos, const long& width, const int& negLog10P_scaled)
+{
+  encodeLE32(buf, static_cast<unsigned long>(chromID));
+  encodeLE32(buf + 4, static_cast<unsigned long>(begPos));
+  encodeLE32(buf + 8, static_cast<unsigned long>(width));
+  encodeLE32(buf + 12, static_cast<unsigned long>(negLog10P_scaled));
+}
+
+inline void decodeIntermediateRecord(const unsigned char* p, int& chromID, int& begPos, int& width, int& negLog10P_scaled)
+{
+  chromID = static_cast<int>(decodeLE32(p));
+  begPos = static_cast<int>(decodeLE32(p + 4));
+  width = static_cast<int>(decodeLE32(p + 8));
+  negLog10P_scaled = static_cast<int>(decodeLE32(p + 12));
+}
+
+#endif // HOTSPOT2_INTERMEDIATE_H
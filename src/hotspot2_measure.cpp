@@ -0,0 +1,152 @@
+// To compile this code into an executable,
+// simply enter the command
+//
+// $ g++ -O3 hotspot2_measure.cpp -o hotspot2_measure
+//
+// or substitute any desired name for the executable for the last argument.
+// The argument -O3 (capital "oh") generates optimized code;
+// it can be omitted if desired.
+// Any C++ compiler can be used in place of g++.
+//
+// This program runs a command and reports its wall-clock time and peak resident set size,
+// for the benchmarks run by "make bench" (see scripts/benchmark_pipeline.sh).
+// The command inherits this program's standard input and output, so it can be redirected as usual:
+//
+// $ hotspot2_measure -o stage.time hotspot2_part1 -c chr.txt -p pvals.txt < in.bed > out.txt
+//
+// One line is written:  wall time (seconds), peak RSS (KiB), and the command's exit status, tab-separated.
+//
+#include "hotspot2_version.h" // for versioning
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+  string outfilename = "";
+  int print_help = 0;
+  int print_version = 0;
+
+  static struct option long_options[] = {
+    { "output", required_argument, 0, 'o' },
+    { "help", no_argument, &print_help, 1 },
+    { "version", no_argument, &print_version, 1 },
+    { 0, 0, 0, 0 }
+  };
+
+  // "+" stops option parsing at the command, so that its own options are passed to it.
+  int c;
+  while ((c = getopt_long(argc, argv, "+o:hvV", long_options, NULL)) != -1)
+    {
+      switch (c)
+        {
+        case 'o':
+          outfilename = optarg;
+          break;
+	case 'h':
+          print_help = 1;
+          break;
+        case 'v':
+        case 'V':
+          print_version = 1;
+          break;
+        case 0:
+          // long option received, do nothing
+          break;
+        default:
+          print_help = 1;
+        }
+    }
+
+  if (!print_help && !print_version && optind >= argc)
+    {
+      cerr << "Error:  No command was given."
+	   << endl
+	   << endl;
+      print_help = 1;
+    }
+
+  if (print_help)
+    {
+      cerr << "Usage:  " << argv[0] << " [options] command [arguments]\n"
+           << "\n"
+           << "Runs the command, then writes its wall time (seconds), peak resident set size (KiB),\n"
+           << "and exit status on one tab-separated line.  The command's exit status is returned.\n"
+           << "\n"
+           << "Options: \n"
+           << "  -o, --output=FILE              A file to write the measurements to (STDERR)\n"
+           << "  -v, --version                  Print the version information and exit\n"
+           << "  -h, --help                     Display this helpful help\n"
+           << endl
+           << endl;
+      return -1;
+    }
+
+  if (print_version)
+    {
+      cout << argv[0] << " version " << hotspot2_VERSION_MAJOR
+           << '.' << hotspot2_VERSION_MINOR << endl;
+      return 0;
+    }
+
+  struct timeval t0, t1;
+  gettimeofday(&t0, NULL);
+  pid_t pid = fork();
+  if (-1 == pid)
+    {
+      cerr << "Error:  Unable to fork:  " << strerror(errno) << endl
+           << endl;
+      return -1;
+    }
+  if (0 == pid)
+    {
+      execvp(argv[optind], argv + optind);
+      cerr << "Error:  Unable to run \"" << argv[optind] << "\":  " << strerror(errno) << endl
+           << endl;
+      _exit(127);
+    }
+
+  int status(0);
+  struct rusage usage;
+  while (-1 == wait4(pid, &status, 0, &usage))
+    {
+      if (errno != EINTR)
+        {
+          cerr << "Error:  Failed to wait for \"" << argv[optind] << "\":  " << strerror(errno) << endl
+               << endl;
+          return -1;
+        }
+    }
+  gettimeofday(&t1, NULL);
+
+  const double seconds(static_cast<double>(t1.tv_sec - t0.tv_sec) + 1.0e-6 * static_cast<double>(t1.tv_usec - t0.tv_usec));
+  const int exitStatus(WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+  ofstream ofs;
+  if (!outfilename.empty())
+    {
+      ofs.open(outfilename.c_str());
+      if (!ofs)
+        {
+          cerr << "Error:  Unable to open file \"" << outfilename << "\" for write." << endl
+               << endl;
+          return -1;
+        }
+    }
+  ostream& os = outfilename.empty() ? cerr : ofs;
+  os.setf(ios::fixed);
+  os.precision(3);
+  os << seconds << '\t' << usage.ru_maxrss << '\t' << exitStatus << endl; // ru_maxrss is in KiB on Linux
+
+  return exitStatus;
+}
@@ -0,0 +1,633 @@
+// To compile this code into an executable,
+// simply enter the command
+//
+// $ g++ -O3 -pthread hotspot2_microbench.cpp -o hotspot2_microbench
+//
+// or substitute any desired name for the executable for the last argument.
+// The argument -O3 (capital "oh") generates optimized code;
+// it can be omitted if desired.
+// Any C++ compiler can be used in place of g++.
+//
+// This program times the statistical hot paths of hotspot2_part1, hotspot2_part2 and findVarWidthPeaks
+// in isolation, on synthetic tallies like those of scripts/synthetic_cutcounts.sh, and reports the time
+// per operation of each one (mean, standard deviation, minimum and maximum over the repetitions).
+// Unlike "make bench," which times whole programs, it shows which kernel a change has affected.
+//
+#define HOTSPOT2_MICROBENCH // for BackgroundRegionManager's bench*() hooks
+#include "findVarWidthPeaks.h"
+#include "hotspot2_fdr.h"
+#include "hotspot2_pvalues.h"
+#include "hotspot2_version.h" // for versioning
+#include <cmath>
+#include <cstdlib>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Put the windowSize sites starting with counts[first] into the background region, then fit the null model to it.
+void fillWindow(BackgroundRegionManager& brm, string* chrom, const vector<int>& counts,
+		const long& first, const int& windowSize);
+void fillWindow(BackgroundRegionManager& brm, string* chrom, const vector<int>& counts,
+		const long& first, const int& windowSize)
+{
+  SiteRange s;
+  s.chrom = chrom;
+  s.ID = NULL;
+  s.pval = -1.;
+  s.hasPval = false;
+#ifdef DEBUG
+  s.sampled = false;
+#endif
+  brm.setBounds(chrom, static_cast<int>(first) + 1, static_cast<int>(first) + windowSize);
+  for (int i = 0; i < windowSize; i++)
+    {
+      s.begPos = first + i;
+      s.endPos = s.begPos + 1;
+      s.count = counts[first + i];
+      brm.add(s);
+    }
+  brm.benchFitNullModel();
+}
+
+// Discards everything written to it, so that output is formatted but costs no I/O.
+class NullBuffer : public streambuf {
+protected:
+  int overflow(int c) { return c; };
+};
+
+// Random deviates, from erand48(), so that the synthetic data is the same on every run.
+double gammaDeviate(const double& shape, unsigned short xsubi[3]);
+double gammaDeviate(const double& shape, unsigned short xsubi[3])
+{
+  // Marsaglia and Tsang; requires shape >= 1.
+  const double d(shape - 1./3.), c(1./sqrt(9.*d));
+  double x, v, u;
+  for (;;)
+    {
+      do
+	{
+	  x = sqrt(-2.*log(1. - erand48(xsubi))) * cos(6.283185307179586 * erand48(xsubi));
+	  v = 1. + c*x;
+	} while (v <= 0);
+      v = v*v*v;
+      u = 1. - erand48(xsubi);
+      if (log(u) < 0.5*x*x + d - d*v + d*log(v))
+	return d*v;
+    }
+}
+
+int poissonDeviate(const double& lambda, unsigned short xsubi[3]);
+int poissonDeviate(const double& lambda, unsigned short xsubi[3])
+{
+  const double L(exp(-lambda));
+  double p(erand48(xsubi));
+  int k(0);
+  while (p > L)
+    {
+      k++;
+      p *= erand48(xsubi);
+    }
+  return k;
+}
+
+// Tallies of cuts within 100 bp of each of numSites contiguous sites, generated as in scripts/synthetic_cutcounts.sh
+// with its default settings (apart from the depth), except that there are no gaps.
+void synthesizeTallies(const long& numSites, const int& depth, vector<int>& counts);
+void synthesizeTallies(const long& numSites, const int& depth, vector<int>& counts)
+{
+  const int RADIUS(100), WIDTH(2*RADIUS + 1);
+  const double SHAPE(4.), HOTSPOTS_PER_MB(50.), baseRate(static_cast<double>(depth) / WIDTH);
+  unsigned short xsubi[3] = { 12345, 0, 0 };
+  vector<int> cuts(WIDTH, 0);
+  double blockRate(baseRate), fold(1.);
+  int hsLeft(0), sum(0);
+
+  counts.clear();
+  counts.reserve(numSites);
+  for (long pos = 0; static_cast<long>(counts.size()) < numSites; pos++)
+    {
+      if (0 == pos % 1000)
+	blockRate = baseRate * gammaDeviate(SHAPE, xsubi) / SHAPE;
+      if (hsLeft > 0)
+	hsLeft--;
+      else
+	{
+	  fold = 1.;
+	  if (erand48(xsubi) * 1000000. < HOTSPOTS_PER_MB)
+	    {
+	      hsLeft = 150 + static_cast<int>(erand48(xsubi) * 1350.);
+	      fold = 3. + erand48(xsubi) * 17.;
+	    }
+	}
+      const int i(static_cast<int>(pos % WIDTH));
+      sum -= cuts[i];
+      cuts[i] = poissonDeviate(blockRate * fold, xsubi);
+      sum += cuts[i];
+      if (pos >= 2*RADIUS) // the window centered on pos - RADIUS is complete
+	counts.push_back(sum);
+    }
+}
+
+// A local maximum of a Region:  the Positions posns[beg..end], all of the same height.
+struct LocalMax {
+  int region;
+  int beg;
+  int end;
+};
+
+// The inputs shared by the benchmarks, derived from one chromosome of synthetic tallies.
+struct Workload {
+  Workload(void) : os(&nullBuffer), pChrom(NULL), windowSize(0),
+		   pFeeder(NULL), feederPos(0), pSiteManager(NULL), siteManagerPos(0) {};
+  ~Workload(void);
+  NullBuffer nullBuffer;
+  ostream os; // output is discarded
+  ChromosomeTable chroms;
+  string* pChrom;
+  int windowSize;
+  NullModelSettings nullModel;
+  vector<int> counts; // one per bp
+  vector<BackgroundRegionManager*> windows; // background regions, filled and fitted, spread across the chromosome
+  vector<int> tailKs; // counts to sum the upper tails from, cycling through the windows
+  vector<long double> negBinomParams; // m and r, from the first window
+  int kMaxNegBinom; // the pmf is computed out to this count
+  vector<long double> pvals; // one per bp, from the first window's null model
+  vector<long> hist; // of the scaled -log10(pvals)
+  vector<Region> regions; // contiguous stretches of high tallies
+  vector<LocalMax> localMaxima;
+  ScoreHistogram scores; // written to by the following
+  SiteFeeder* pFeeder;
+  long feederPos; // the next site to feed to it
+  SiteManager* pSiteManager;
+  long siteManagerPos; // the next site to add to it
+
+private:
+  Workload(const Workload&); // deny use of the copy constructor
+};
+
+Workload::~Workload(void)
+{
+  for (vector<BackgroundRegionManager*>::iterator it = windows.begin(); it != windows.end(); it++)
+    delete *it;
+  delete pFeeder;
+  delete pSiteManager;
+}
+
+static Workload workload;
+
+void setUpWorkload(const long& numSites, const int& windowSize, const int& depth, const int& numWindows);
+void setUpWorkload(const long& numSites, const int& windowSize, const int& depth, const int& numWindows)
+{
+  Workload& w = workload;
+  w.pChrom = w.chroms.intern("chrSynthetic");
+  w.windowSize = windowSize;
+  synthesizeTallies(numSites, depth, w.counts);
+
+  for (int i = 0; i < numWindows; i++)
+    {
+      const long first(numWindows > 1 ? i * (numSites - windowSize) / (numWindows - 1) : 0);
+      BackgroundRegionManager* pBRM = new BackgroundRegionManager(w.nullModel);
+      fillWindow(*pBRM, w.pChrom, w.counts, first, windowSize);
+      w.windows.push_back(pBRM);
+    }
+
+  // Upper-tail sums start at the counts above the mean, out to the largest observed count.
+  const long double mean(w.windows[0]->benchPmfParams()[0]);
+  int maxCount(0);
+  for (unsigned long i = 0; i < w.counts.size(); i++)
+    if (w.counts[i] > maxCount)
+      maxCount = w.counts[i];
+  for (int k = static_cast<int>(ceil(mean)); k <= maxCount; k++)
+    w.tailKs.push_back(k);
+
+  if (w.windows[0]->benchIsNegativeBinomial())
+    w.negBinomParams = w.windows[0]->benchPmfParams();
+  else
+    {
+      // The background wasn't overdispersed; use a typical fit instead.
+      w.negBinomParams.push_back(static_cast<long double>(depth));
+      w.negBinomParams.push_back(4.);
+    }
+  w.kMaxNegBinom = w.windows[0]->benchCutoff();
+  if (w.kMaxNegBinom < 2*depth)
+    w.kMaxNegBinom = 2*depth;
+
+  for (unsigned long i = 0; i < w.counts.size(); i++)
+    {
+      const long double pval(w.counts[i] > 0 ? upperTailNegativeBinomial(w.counts[i], w.negBinomParams) : 1.);
+      const int score(scaledNegLog10P(pval));
+      w.pvals.push_back(pval);
+      if (static_cast<unsigned long>(score) >= w.hist.size())
+	w.hist.resize(score + 1, 0);
+      w.hist[score]++;
+    }
+
+  // Regions are the stretches of tallies of at least twice the depth, as hotspots would be;
+  // their heights are the tallies, which are smooth like the densities findVarWidthPeaks receives.
+  const int MIN_REGION_WIDTH(20);
+  Region reg;
+  Position p;
+  int idxOfMax(0);
+  for (unsigned long i = 0; i <= w.counts.size(); i++)
+    {
+      if (i < w.counts.size() && w.counts[i] >= 2*depth)
+	{
+	  p.x = static_cast<long>(i) + 1;
+	  p.y = static_cast<float>(w.counts[i]);
+	  p.idx = static_cast<int>(reg.posns.size());
+	  if (reg.posns.empty() || p.y > reg.posns[idxOfMax].y)
+	    idxOfMax = p.idx;
+	  reg.posns.push_back(p);
+	  continue;
+	}
+      if (static_cast<int>(reg.posns.size()) >= MIN_REGION_WIDTH)
+	{
+	  const int n(static_cast<int>(reg.posns.size())), r(static_cast<int>(w.regions.size()));
+	  reg.posSummit = reg.posns[idxOfMax].x;
+	  for (int j = 0; j < n; j++)
+	    {
+	      LocalMax lm;
+	      lm.region = r;
+	      lm.beg = j;
+	      while (j + 1 < n && reg.posns[j + 1].y == reg.posns[j].y)
+		j++;
+	      lm.end = j;
+	      if ((0 == lm.beg || reg.posns[lm.beg - 1].y < reg.posns[lm.beg].y)
+		  && (n - 1 == lm.end || reg.posns[lm.end + 1].y < reg.posns[lm.end].y))
+		w.localMaxima.push_back(lm);
+	    }
+	  w.regions.push_back(reg);
+	}
+      reg.posns.clear();
+    }
+}
+
+// Each benchmark performs numOps operations, and returns a value derived from their results,
+// so that the compiler can't discard them.
+double benchNextProbNegativeBinomial(const long& numOps);
+double benchNextProbNegativeBinomial(const long& numOps)
+{
+  const vector<long double>& params = workload.negBinomParams;
+  const long double prob0(pow(params[1] / (params[0] + params[1]), params[1]));
+  long double sum(0), pmf(prob0);
+  int k(0);
+  for (long i = 0; i < numOps; i++)
+    {
+      if (++k > workload.kMaxNegBinom)
+	{
+	  k = 1;
+	  pmf = prob0;
+	}
+      pmf = nextProbNegativeBinomial(k, pmf, params);
+      sum += pmf;
+    }
+  return static_cast<double>(sum);
+}
+
+double benchTailSum(const long& numOps);
+double benchTailSum(const long& numOps)
+{
+  const vector<int>& ks = workload.tailKs;
+  long double sum(0);
+  unsigned long w(0), j(0);
+  for (long i = 0; i < numOps; i++)
+    {
+      sum += workload.windows[w]->benchTailSum(ks[j]);
+      if (++j == ks.size())
+	{
+	  j = 0;
+	  w = (w + 1) % workload.windows.size();
+	}
+    }
+  return static_cast<double>(sum);
+}
+
+double benchFindCutoff(const long& numOps, const bool& sliding);
+double benchFindCutoff(const long& numOps, const bool& sliding)
+{
+  long sum(0);
+  for (long i = 0; i < numOps; i++)
+    {
+      BackgroundRegionManager& brm = *workload.windows[i % workload.windows.size()];
+      brm.benchFindCutoff(sliding);
+      sum += brm.benchCutoff();
+    }
+  return static_cast<double>(sum);
+}
+
+double benchFindCutoffFull(const long& numOps);
+double benchFindCutoffFull(const long& numOps)
+{
+  return benchFindCutoff(numOps, false);
+}
+
+double benchFindCutoffSliding(const long& numOps);
+double benchFindCutoffSliding(const long& numOps)
+{
+  return benchFindCutoff(numOps, true);
+}
+
+// One operation is one bp, fed to hotspot2_part1's SiteFeeder one site per line,
+// so nearly all of them are slid across with BackgroundRegionManager::slideAndCompute().
+// The feeder carries on along the chromosome from one call to the next, so that filling
+// the first background region falls within the warm-up.
+double benchSlideAndCompute(const long& numOps);
+double benchSlideAndCompute(const long& numOps)
+{
+  Workload& w = workload;
+  if (!w.pFeeder)
+    w.pFeeder = new SiteFeeder(w.windowSize, w.nullModel, w.os, w.scores, w.chroms, false);
+  const long n(static_cast<long>(w.counts.size()));
+  for (long i = 0; i < numOps; i++, w.feederPos++)
+    w.pFeeder->processRange(w.pChrom, w.feederPos, w.feederPos + 1, w.counts[w.feederPos % n]);
+  return static_cast<double>(w.feederPos);
+}
+
+// Sites get their P-values half a background window after they're added, as they do in hotspot2_part1.
+// As above, the sites carry on from one call to the next.
+double benchProcessPvalue(const long& numOps);
+double benchProcessPvalue(const long& numOps)
+{
+  Workload& w = workload;
+  const long n(static_cast<long>(w.pvals.size())), lag(w.windowSize / 2);
+  SiteRange s;
+  s.chrom = w.pChrom;
+  s.ID = NULL;
+  s.pval = -1.;
+  s.hasPval = false;
+#ifdef DEBUG
+  s.sampled = false;
+#endif
+  if (!w.pSiteManager)
+    {
+      w.pSiteManager = new SiteManager(w.os, w.scores, w.chroms, w.windowSize, false);
+      for (w.siteManagerPos = 0; w.siteManagerPos < lag; w.siteManagerPos++)
+	{
+	  s.begPos = w.siteManagerPos;
+	  s.endPos = s.begPos + 1;
+	  w.pSiteManager->addSite(s);
+	}
+    }
+  for (long i = 0; i < numOps; i++, w.siteManagerPos++)
+    {
+      s.begPos = w.siteManagerPos;
+      s.endPos = s.begPos + 1;
+      w.pSiteManager->addSite(s);
+      w.pSiteManager->processPvalue(w.pvals[(w.siteManagerPos - lag) % n]
+#ifdef DEBUG
+				    , false
+#endif
+				    );
+    }
+  return static_cast<double>(w.siteManagerPos);
+}
+
+double benchBuildFDRtable(const long& numOps);
+double benchBuildFDRtable(const long& numOps)
+{
+  vector<long double> fdr;
+  long double sum(0);
+  for (long i = 0; i < numOps; i++)
+    {
+      buildFDRtable(workload.hist, fdr);
+      sum += fdr[fdr.size() - 1];
+    }
+  return static_cast<double>(sum);
+}
+
+double benchGetPeakBoundaries(const long& numOps);
+double benchGetPeakBoundaries(const long& numOps)
+{
+  const vector<LocalMax>& maxima = workload.localMaxima;
+  const long MIN_WIDTH(20);
+  long sum(0);
+  for (long i = 0; i < numOps; i++)
+    {
+      const LocalMax& lm = maxima[i % maxima.size()];
+      int idxL(lm.beg), idxR(lm.end);
+      if (getPeakBoundaries(workload.regions[lm.region], idxL, idxR, MIN_WIDTH))
+	sum += idxR - idxL;
+    }
+  return static_cast<double>(sum);
+}
+
+struct Benchmark {
+  const char* name;
+  double (*run)(const long& numOps);
+};
+
+static const Benchmark benchmarks[] = {
+  { "nextProbNegativeBinomial", &benchNextProbNegativeBinomial },
+  { "tailSum", &benchTailSum },
+  { "findCutoff", &benchFindCutoffFull },
+  { "findCutoff_sliding", &benchFindCutoffSliding },
+  { "slideAndCompute", &benchSlideAndCompute },
+  { "processPvalue", &benchProcessPvalue },
+  { "buildFDRtable", &benchBuildFDRtable },
+  { "getPeakBoundaries", &benchGetPeakBoundaries }
+};
+static const int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+static volatile double sink; // receives the benchmarks' results
+
+double timeOps(const Benchmark& b, const long& numOps);
+double timeOps(const Benchmark& b, const long& numOps)
+{
+  const double start(wallClockSeconds());
+  sink = sink + b.run(numOps);
+  return wallClockSeconds() - start;
+}
+
+// After a warm-up, the number of operations per repetition is raised until a repetition takes minSeconds;
+// then each repetition is timed separately, and the time per operation is summarized across them.
+void runBenchmark(const Benchmark& b, const int& reps, const double& minSeconds, ostream& os);
+void runBenchmark(const Benchmark& b, const int& reps, const double& minSeconds, ostream& os)
+{
+  long numOps(1);
+  double secs;
+  while ((secs = timeOps(b, numOps)) < minSeconds)
+    {
+      double factor(secs > 0 ? 1.2 * minSeconds / secs : 10.);
+      if (factor > 10.)
+	factor = 10.;
+      const long next(static_cast<long>(ceil(factor * static_cast<double>(numOps))));
+      numOps = next > numOps ? next : numOps + 1;
+    }
+
+  vector<double> nsPerOp;
+  double sum(0), sumSq(0), minVal(0), maxVal(0);
+  for (int r = 0; r < reps; r++)
+    {
+      const double ns(1.0e9 * timeOps(b, numOps) / static_cast<double>(numOps));
+      if (0 == r || ns < minVal)
+	minVal = ns;
+      if (0 == r || ns > maxVal)
+	maxVal = ns;
+      sum += ns;
+      nsPerOp.push_back(ns);
+    }
+  const double mean(sum / reps);
+  for (int r = 0; r < reps; r++)
+    sumSq += (nsPerOp[r] - mean) * (nsPerOp[r] - mean);
+  const double stddev(reps > 1 ? sqrt(sumSq / (reps - 1)) : 0.);
+
+  os << b.name << '\t' << numOps << '\t' << reps << '\t'
+     << mean << '\t' << stddev << '\t' << minVal << '\t' << maxVal << endl;
+}
+
+int main(int argc, char* argv[])
+{
+  // Option defaults
+  long num_sites = 400000;
+  int background_size = 50001;
+  int depth = 30;
+  int num_windows = 8;
+  int reps = 10;
+  double min_seconds = 0.2;
+
+  int print_help = 0;
+  int print_version = 0;
+  int list_benchmarks = 0;
+
+  static struct option long_options[] = {
+    { "sites", required_argument, 0, 'n' },
+    { "background_size", required_argument, 0, 'b' },
+    { "depth", required_argument, 0, 'd' },
+    { "windows", required_argument, 0, 'w' },
+    { "reps", required_argument, 0, 'r' },
+    { "min-seconds", required_argument, 0, 'm' },
+    { "list", no_argument, &list_benchmarks, 1 },
+    { "help", no_argument, &print_help, 1 },
+    { "version", no_argument, &print_version, 1 },
+    { 0, 0, 0, 0 }
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "n:b:d:w:r:m:lhvV", long_options, NULL)) != -1)
+    {
+      switch (c)
+        {
+        case 'n':
+          num_sites = atol(optarg);
+          break;
+        case 'b':
+          background_size = atoi(optarg);
+          break;
+        case 'd':
+          depth = atoi(optarg);
+          break;
+        case 'w':
+          num_windows = atoi(optarg);
+          break;
+        case 'r':
+          reps = atoi(optarg);
+          break;
+        case 'm':
+          min_seconds = atof(optarg);
+          break;
+        case 'l':
+          list_benchmarks = 1;
+          break;
+        case 'h':
+          print_help = 1;
+          break;
+        case 'v':
+        case 'V':
+          print_version = 1;
+          break;
+        case 0:
+          // long option received, do nothing
+          break;
+        default:
+          print_help = 1;
+        }
+    }
+
+  if (!print_help && !print_version && (background_size < 1 || num_sites < background_size))
+    {
+      cerr << "Error:  The number of sites must be at least the size of the background region (" << background_size << ")."
+	   << endl
+	   << endl;
+      print_help = 1;
+    }
+  if (!print_help && !print_version && (depth < 1 || num_windows < 1 || reps < 1 || min_seconds <= 0))
+    {
+      cerr << "Error:  The depth, number of windows, number of repetitions and minimum time must be positive."
+	   << endl
+	   << endl;
+      print_help = 1;
+    }
+
+  vector<const Benchmark*> selected;
+  for (int i = optind; !print_help && !print_version && i < argc; i++)
+    {
+      int j;
+      for (j = 0; j < numBenchmarks; j++)
+	if (string(argv[i]) == benchmarks[j].name)
+	  break;
+      if (numBenchmarks == j)
+	{
+	  cerr << "Error:  Unknown benchmark \"" << argv[i] << "\"; use --list to see them."
+	       << endl
+	       << endl;
+	  print_help = 1;
+	}
+      else
+	selected.push_back(&benchmarks[j]);
+    }
+
+  if (print_help)
+    {
+      cerr << "Usage:  " << argv[0] << " [options] [benchmark ...]\n"
+           << "\n"
+           << "Times the statistical hot paths on synthetic tallies, and writes the time per operation\n"
+           << "of each benchmark (mean, standard deviation, minimum and maximum over the repetitions, in ns)\n"
+           << "as tab-separated columns.  All benchmarks are run if none are named.\n"
+           << "\n"
+           << "Options: \n"
+           << "  -n, --sites=NUM                Number of sites of synthetic tallies (400000)\n"
+           << "  -b, --background_size=SIZE     The size of the background region (50001)\n"
+           << "  -d, --depth=DEPTH              Mean tally outside hotspots (30)\n"
+           << "  -w, --windows=NUM              Number of background regions to cycle through (8)\n"
+           << "  -r, --reps=NUM                 Timed repetitions per benchmark (10)\n"
+           << "  -m, --min-seconds=SECONDS      Minimum time per repetition (0.2)\n"
+           << "  -l, --list                     List the benchmarks and exit\n"
+           << "  -v, --version                  Print the version information and exit\n"
+           << "  -h, --help                     Display this helpful help\n"
+           << endl
+           << endl;
+      return -1;
+    }
+
+  if (print_version)
+    {
+      cout << argv[0] << " version " << hotspot2_VERSION_MAJOR
+           << '.' << hotspot2_VERSION_MINOR << endl;
+      return 0;
+    }
+
+  if (list_benchmarks)
+    {
+      for (int j = 0; j < numBenchmarks; j++)
+	cout << benchmarks[j].name << '\n';
+      return 0;
+    }
+
+  if (selected.empty())
+    for (int j = 0; j < numBenchmarks; j++)
+      selected.push_back(&benchmarks[j]);
+
+  setUpWorkload(num_sites, background_size, depth, num_windows);
+
+  cout << "# workload: -n " << num_sites << " -b " << background_size << " -d " << depth << " -w " << num_windows << '\n'
+       << "benchmark\tops_per_rep\treps\tmean_ns_per_op\tstddev_ns_per_op\tmin_ns_per_op\tmax_ns_per_op" << endl;
+  cout.setf(ios::fixed);
+  cout.precision(2);
+  for (unsigned long i = 0; i < selected.size(); i++)
+    runBenchmark(*selected[i], reps, min_seconds, cout);
+
+  return 0;
+}
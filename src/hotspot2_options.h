@@ -0,0 +1,434 @@
+// The options shared by hotspot2_part1 and hotspot2_engine:  those of the null model
+// and of reading and processing part 1's input.  Each program adds its own options to these,
+// hands every option that getopt_long returns to Part1Options::parse() before trying its own,
+// and calls validate() once all of them have been read; Part1Options then runs part 1.
+//
+#ifndef HOTSPOT2_OPTIONS_H
+#define HOTSPOT2_OPTIONS_H
+
+#include "hotspot2_pvalues.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Part1Options {
+public:
+  Part1Options(void);
+  void addLongOptions(vector<struct option>& longOptions);
+  static const char* shortOptions(void) { return "b:m:n:t:k:F:C:u:N:P:i:"; };
+  bool parse(const int& c, const char* arg, int& print_help); // false if c isn't one of these options
+  bool validate(const bool& threadsRequireInputFile) const; // reports the first problem found
+  static void writeHelp(ostream& os);
+  bool inputIsFile(void) const { return !infilename.empty() && infilename != "-"; };
+  string describeRun(void) const; // identifies the options that affect the output
+  CheckpointSettings checkpointSettings(const bool& binaryOutput) const;
+  bool start(void); // sets up nullModel, and opens the --stats file
+  bool process(const CheckpointSettings& checkpoint, ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist,
+	       const bool& binaryOutput) const;
+  bool finish(const ChromosomeTable& chroms); // reports on --verify-precision and --table-cache-stats, and writes the --stats file
+
+  int backgroundSize;
+  int samplingInterval;
+  int smoothingParameter; // recommend ca. 15 when the maximum # of sampled observations is ca. 250
+  int numThreads;
+  long chunkSize; // 0:  don't split chromosomes
+  string inputFormat;
+  string centerSitesFilename;
+  string cutcountsFilename;
+  int neighborhoodSize;
+  long double minPvalue; // 0:  no floor
+  int closedFormTails;
+  int tableCacheSize; // 0:  no cache
+  int tableCacheStats;
+  int doublePrecision;
+  int verifyPrecision;
+  int verifyInterval; // 0:  don't verify
+  string statsFilename;
+  string infilename;
+  string checkpointDir;
+  int resume;
+  string inputId; // see CheckpointSettings
+  NullModelSettings nullModel; // set up by start()
+
+private:
+  Part1Options(const Part1Options&); // deny use of the copy constructor
+  PrecisionCheck m_precisionCheck;
+  NullModelCacheStats m_tableCacheStats;
+  RunStats m_runStats;
+  ofstream m_ofsStats;
+  double m_startTime;
+};
+
+Part1Options::Part1Options(void)
+  : backgroundSize(50001), samplingInterval(1), smoothingParameter(5), numThreads(1), chunkSize(0),
+    inputFormat("bed"), centerSitesFilename(""), cutcountsFilename(""), neighborhoodSize(100),
+    minPvalue(0.), closedFormTails(0), tableCacheSize(0), tableCacheStats(0), doublePrecision(0), verifyPrecision(0), verifyInterval(0),
+    statsFilename(""), infilename(""), checkpointDir(""), resume(0), inputId(""), m_startTime(0)
+{
+}
+
+void Part1Options::addLongOptions(vector<struct option>& longOptions)
+{
+  static const struct option withArgs[] = {
+    { "background_size", required_argument, 0, 'b' },
+    { "sampling_interval", required_argument, 0, 'n' },
+    { "smoothing_parameter", required_argument, 0, 'm' },
+    { "input", required_argument, 0, 'i' },
+    { "threads", required_argument, 0, 't' },
+    { "chunk_size", required_argument, 0, 'k' },
+    { "input-format", required_argument, 0, 'F' },
+    { "center_sites", required_argument, 0, 'C' },
+    { "cutcounts", required_argument, 0, 'u' },
+    { "neighborhood_size", required_argument, 0, 'N' },
+    { "min-pvalue", required_argument, 0, 'P' },
+    { "table-cache", required_argument, 0, 'T' }, // no short option
+    { "verify", required_argument, 0, 'Y' }, // no short option
+    { "stats", required_argument, 0, 'S' }, // no short option
+    { "checkpoint", required_argument, 0, 'K' }, // no short option
+    { "input-id", required_argument, 0, 'I' } // no short option
+  };
+  longOptions.insert(longOptions.end(), withArgs, withArgs + sizeof(withArgs) / sizeof(withArgs[0]));
+  const struct option closedFormTailsOption = { "closed-form-tails", no_argument, &closedFormTails, 1 };
+  const struct option tableCacheStatsOption = { "table-cache-stats", no_argument, &tableCacheStats, 1 };
+  const struct option doublePrecisionOption = { "double-precision", no_argument, &doublePrecision, 1 };
+  const struct option verifyPrecisionOption = { "verify-precision", no_argument, &verifyPrecision, 1 };
+  const struct option resumeOption = { "resume", no_argument, &resume, 1 };
+  longOptions.push_back(closedFormTailsOption);
+  longOptions.push_back(tableCacheStatsOption);
+  longOptions.push_back(doublePrecisionOption);
+  longOptions.push_back(verifyPrecisionOption);
+  longOptions.push_back(resumeOption);
+}
+
+bool Part1Options::parse(const int& c, const char* arg, int& print_help)
+{
+  switch (c)
+    {
+    case 'b':
+      backgroundSize = atoi(arg);
+      break;
+    case 'n':
+      samplingInterval = atoi(arg);
+      break;
+    case 'm':
+      smoothingParameter = atoi(arg);
+      break;
+    case 'i':
+      infilename = arg;
+      break;
+    case 't':
+      numThreads = atoi(arg);
+      break;
+    case 'k':
+      chunkSize = atol(arg);
+      break;
+    case 'F':
+      inputFormat = arg;
+      break;
+    case 'C':
+      centerSitesFilename = arg;
+      break;
+    case 'u':
+      cutcountsFilename = arg;
+      break;
+    case 'N':
+      neighborhoodSize = atoi(arg);
+      break;
+    case 'T':
+      tableCacheSize = atoi(arg);
+      break;
+    case 'Y':
+      verifyInterval = atoi(arg);
+      break;
+    case 'S':
+      statsFilename = arg;
+      break;
+    case 'K':
+      checkpointDir = arg;
+      break;
+    case 'I':
+      inputId = arg;
+      break;
+    case 'P':
+      {
+	istringstream iss(arg); // allows scientific notation
+	if (!(iss >> minPvalue) || !(iss >> ws).eof())
+	  {
+	    cerr << "Error:  Invalid P-value floor \"" << arg << "\"." << endl
+		 << endl;
+	    print_help = 1;
+	  }
+      }
+      break;
+    default:
+      return false;
+    }
+  return true;
+}
+
+bool Part1Options::validate(const bool& threadsRequireInputFile) const
+{
+  if (inputFormat != "bed" && inputFormat != "bin")
+    {
+      cerr << "Error:  Unrecognized input format \"" << inputFormat << "\"; must be \"bed\" or \"bin\"."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (centerSitesFilename.empty() != cutcountsFilename.empty())
+    {
+      cerr << "Error:  --center_sites and --cutcounts must be supplied together."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (!centerSitesFilename.empty() && (numThreads != 1 || !infilename.empty()))
+    {
+      cerr << "Error:  --center_sites and --cutcounts cannot be combined with -i or -t."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (minPvalue < 0 || minPvalue >= 1)
+    {
+      cerr << "Error:  The P-value floor must be at least 0 (no floor) and less than 1."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (tableCacheSize < 0)
+    {
+      cerr << "Error:  The number of null-model tables to cache must be nonnegative."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (tableCacheStats && 0 == tableCacheSize)
+    {
+      cerr << "Error:  --table-cache-stats requires --table-cache."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (verifyInterval < 0)
+    {
+      cerr << "Error:  The number of slides between verifications must be nonnegative."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (closedFormTails && (doublePrecision || verifyPrecision))
+    {
+      cerr << "Error:  --closed-form-tails cannot be combined with --double-precision or --verify-precision,\n"
+	   << "which apply to P-values computed from pmfs."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (doublePrecision && verifyPrecision)
+    {
+      cerr << "Error:  --double-precision and --verify-precision cannot be combined;\n"
+	   << "--verify-precision writes the long double results and compares the double-precision ones against them."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (neighborhoodSize < 0)
+    {
+      cerr << "Error:  The neighborhood size must be nonnegative."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (numThreads < 1)
+    {
+      cerr << "Error:  The number of threads must be at least 1."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (threadsRequireInputFile && numThreads > 1 && !inputIsFile())
+    {
+      cerr << "Error:  An input file (-i) is required when more than one thread is used."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (resume && checkpointDir.empty())
+    {
+      cerr << "Error:  --resume requires --checkpoint."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (!inputId.empty() && checkpointDir.empty())
+    {
+      cerr << "Error:  --input-id requires --checkpoint."
+	   << endl
+	   << endl;
+      return false;
+    }
+  if (inputId.find('\n') != string::npos)
+    {
+      cerr << "Error:  --input-id cannot contain a newline."
+	   << endl
+	   << endl;
+      return false;
+    }
+  return true;
+}
+
+void Part1Options::writeHelp(ostream& os)
+{
+  os << "  -b, --background_size=SIZE     The size of the background region (50001)\n"
+     << "  -n, --sampling_interval=INT    How often (bp) to sample for null modeling (1)\n"
+     << "  -m, --smoothing_prameter=INT   Smoothing parameter used in null modeling (5)\n"
+     << "  -i, --input=FILE               A file to read input from (STDIN)\n"
+     << "  -F, --input-format=FORMAT      \"bed\" (BED5) or \"bin\" (see hotspot2_bed2bin) (bed)\n"
+     << "  -C, --center_sites=FILE        Tally cut counts around the center sites in this sorted BED file,\n"
+     << "                                 instead of reading tallies from the input; requires -u\n"
+     << "  -u, --cutcounts=FILE           Sorted BED5 file of cut counts (count in field 5) to tally\n"
+     << "  -N, --neighborhood_size=INT    Tally cut counts within INT bp of each center site (100)\n"
+     << "  -t, --threads=INT              Process chromosomes in parallel on INT threads; requires -i (1)\n"
+     << "  -k, --chunk_size=SIZE          With -t, also split chromosomes into chunks of >= SIZE bp,\n"
+     << "                                 cut at gaps wider than half the background region (0 = no split)\n"
+     << "  -P, --min-pvalue=P             Report P-values below P as P, and stop computing the null model's\n"
+     << "                                 pmfs at the count whose P-value reaches it, e.g. 1e-100 (0 = no floor)\n"
+     << "  --closed-form-tails            Compute each P-value directly from the null model's upper tail\n"
+     << "                                 (incomplete beta or gamma function), in time independent of the count\n"
+     << "  --table-cache=INT              Keep the pmfs of the INT most recent null-model fits, for reuse\n"
+     << "                                 when the background statistics recur (0 = no cache) (0)\n"
+     << "  --table-cache-stats            Report the cache's hits, misses and evictions to stderr, for sizing it\n"
+     << "  --double-precision             Compute the null model's pmfs and P-values in double precision,\n"
+     << "                                 which is faster than the default (long double)\n"
+     << "  --verify-precision             Also compute them in double precision, and report the differences\n"
+     << "                                 in scaled -log10(P) to stderr (the output uses long double)\n"
+     << "  --verify=N                     Every N slides of the background window, recompute its statistics\n"
+     << "                                 from scratch, and abort if they disagree with the sliding ones (0 = never) (0)\n"
+     << "  --stats=FILE                   Write counts of the null model's computations, by what prompted them,\n"
+     << "                                 and the time and sites per second for each chromosome to FILE (JSON)\n"
+     << "  --checkpoint=DIR               Keep each chromosome's (or chunk's) output in DIR, marked once it's complete,\n"
+     << "                                 so that an interrupted run can be resumed\n"
+     << "  --resume                       With --checkpoint, skip the chromosomes that an earlier run of the same\n"
+     << "                                 options on the same input completed:  seek past them in an -i file,\n"
+     << "                                 or read through them in other input (e.g., a pipe, or --center_sites)\n"
+     << "  --input-id=STRING              With --checkpoint, identifies input that isn't a regular file, such as a pipe,\n"
+     << "                                 e.g., by the names, sizes and modification times of the files it comes from;\n"
+     << "                                 a checkpoint of such input is only resumed by a run with the same STRING\n";
+}
+
+string Part1Options::describeRun(void) const
+{
+  ostringstream oss;
+  oss.precision(20);
+  oss << "-b " << backgroundSize << " -n " << samplingInterval << " -m " << smoothingParameter
+      << " -k " << chunkSize << " -F " << inputFormat << " -P " << minPvalue
+      << (closedFormTails ? " --closed-form-tails" : "") << (doublePrecision ? " --double-precision" : "");
+  return oss.str();
+}
+
+CheckpointSettings Part1Options::checkpointSettings(const bool& binaryOutput) const
+{
+  CheckpointSettings checkpoint;
+  if (!checkpointDir.empty())
+    {
+      checkpoint.dir = checkpointDir;
+      checkpoint.resume = resume ? true : false;
+      checkpoint.runDescription = describeRun() + (binaryOutput ? " -O bin" : " -O txt");
+      checkpoint.inputId = inputId;
+    }
+  return checkpoint;
+}
+
+bool Part1Options::start(void)
+{
+  nullModel = NullModelSettings();
+  nullModel.samplingInterval = samplingInterval;
+  nullModel.MAlength = smoothingParameter;
+  nullModel.minPvalue = minPvalue;
+  nullModel.closedFormTails = closedFormTails ? true : false;
+  nullModel.tableCacheSize = tableCacheSize;
+  if (tableCacheStats)
+    nullModel.pTableCacheStats = &m_tableCacheStats;
+  nullModel.doubleKernels = doublePrecision ? true : false;
+  if (verifyPrecision)
+    nullModel.pPrecisionCheck = &m_precisionCheck;
+  nullModel.verifyInterval = verifyInterval;
+  if (!statsFilename.empty())
+    {
+      m_ofsStats.open(statsFilename.c_str());
+      if (!m_ofsStats)
+	{
+	  cerr << "Error:  Unable to open file \"" << statsFilename << "\" for write."
+	       << endl
+	       << endl;
+	  return false;
+	}
+      nullModel.pRunStats = &m_runStats;
+    }
+  m_startTime = wallClockSeconds();
+  return true;
+}
+
+// Runs part 1 on a single sample.  Without a checkpoint, one thread reads the input from stdin,
+// which gets redirected to the -i file, if there is one.  A checkpoint of input that can't be sought in
+// (see CheckpointSettings) is kept as it's read.
+bool Part1Options::process(const CheckpointSettings& checkpoint, ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist,
+			   const bool& binaryOutput) const
+{
+  const bool checkpointing(!checkpoint.dir.empty());
+  if (!centerSitesFilename.empty() && checkpointing)
+    return tallyAndProcessInputWithCheckpoint(centerSitesFilename, cutcountsFilename, neighborhoodSize,
+					      backgroundSize, nullModel, checkpoint,
+					      chroms, os, hist, binaryOutput);
+  if (!centerSitesFilename.empty())
+    return tallyAndProcessInput(centerSitesFilename, cutcountsFilename, neighborhoodSize,
+				backgroundSize, nullModel,
+				chroms, os, hist, binaryOutput);
+  if (1 == numThreads && checkpointing && !(inputIsFile() && isRegularFile(infilename)))
+    return parseAndProcessInputWithCheckpoint(infilename, inputFormat == "bin",
+					      backgroundSize, nullModel, checkpoint,
+					      chroms, os, hist, binaryOutput);
+  if (1 == numThreads && !checkpointing)
+    {
+      if (inputIsFile() && freopen(infilename.c_str(), "r", stdin) == NULL)
+	{
+	  cerr << "Error: Couldn't open input file " << infilename << endl;
+	  return false;
+	}
+      return parseAndProcessInput(inputFormat == "bin", backgroundSize, nullModel,
+				  chroms, os, hist, binaryOutput);
+    }
+  return parseAndProcessInputInParallel(infilename, inputFormat == "bin", numThreads, chunkSize,
+					backgroundSize, nullModel, checkpoint,
+					chroms, os, hist, binaryOutput);
+}
+
+bool Part1Options::finish(const ChromosomeTable& chroms)
+{
+  if (verifyPrecision)
+    m_precisionCheck.report(cerr);
+  if (tableCacheStats)
+    m_tableCacheStats.report(cerr);
+  if (!statsFilename.empty())
+    {
+      m_runStats.writeJSON(m_ofsStats, chroms, wallClockSeconds() - m_startTime);
+      m_ofsStats.close();
+      if (!m_ofsStats)
+	{
+	  cerr << "Error:  Failed to write file \"" << statsFilename << "\"." << endl
+	       << endl;
+	  return false;
+	}
+    }
+  return true;
+}
+
+#endif // HOTSPOT2_OPTIONS_H
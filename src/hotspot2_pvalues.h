@@ -0,0 +1,4287 @@
+// The sliding-window null model of hotspot2_part1 and hotspot2_engine, and the machinery that
+// feeds it sites and collects the resulting P-values:  each site's count is compared against
+// the distribution of counts in the background window centered on it, and runs of sites with
+// equal scaled -log10(P) values are written out as ranges (see hotspot2_intermediate.h),
+// while a histogram of the scores is kept for computing FDRs.
+//
+#ifndef HOTSPOT2_PVALUES_H
+#define HOTSPOT2_PVALUES_H
+
+#include "hotspot2_input.h"
+#include "hotspot2_intermediate.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio> // for remove()
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits> // for epsilon()
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <sys/stat.h> // for mkdir() and stat()
+#include <sys/time.h> // for gettimeofday()
+#include <unistd.h> // for close()
+#include <utility> // for pair
+#include <vector>
+
+using namespace std;
+
+// Chromosome names get "interned," i.e., stored once, and each one is assigned an integer
+// in order of first appearance; the integers are written in place of the names in the output.
+// One table is used per run.  When chromosomes are processed on multiple threads,
+// the table is fully populated before the threads are launched, and it is only read thereafter.
+class ChromosomeTable {
+public:
+  ChromosomeTable(void) {};
+  ~ChromosomeTable(void);
+  string* intern(const string& s);
+  string* find(const string& s) const;
+  int idxFromChrom(const string* ptr) const;
+  void write(ostream& os) const;
+  void getIntToChromNameMap(map<int, string*>& mapOut) const;
+
+private:
+  ChromosomeTable(const ChromosomeTable&); // deny use of the copy constructor
+  map<string, string*> m_interned;
+  map<const string*, int> m_chromAsInt;
+  vector<string*> m_namesInOrder;
+};
+
+ChromosomeTable::~ChromosomeTable(void)
+{
+  for (vector<string*>::iterator it = m_namesInOrder.begin(); it != m_namesInOrder.end(); it++)
+    delete *it;
+}
+
+string* ChromosomeTable::intern(const string& s)
+{
+  map<string, string*>::iterator it = m_interned.find(s);
+  if (it == m_interned.end())
+    {
+      string* ptr = new string(s);
+      m_interned[s] = ptr;
+      m_namesInOrder.push_back(ptr);
+      m_chromAsInt[ptr] = static_cast<int>(m_namesInOrder.size());
+      return ptr;
+    }
+  return it->second;
+}
+
+string* ChromosomeTable::find(const string& s) const
+{
+  map<string, string*>::const_iterator it = m_interned.find(s);
+  if (it == m_interned.end())
+    return NULL;
+  return it->second;
+}
+
+int ChromosomeTable::idxFromChrom(const string* ptr) const
+{
+  map<const string*, int>::const_iterator it = m_chromAsInt.find(ptr);
+  if (m_chromAsInt.end() == it)
+    {
+      cerr << "Coding error:  Line " << __LINE__ << ", failed to find \""
+	   << *ptr << "\" in the lookup table." << endl << endl;
+      exit(2);
+    }
+  return it->second;
+}
+
+// Write the integer-to-chromosomeName mapping, in integer order.
+void ChromosomeTable::write(ostream& os) const
+{
+  for (unsigned int i = 0; i < m_namesInOrder.size(); i++)
+    os << i + 1 << '\t' << *m_namesInOrder[i] << '\n';
+}
+
+// The same mapping, as hotspot2_part2 builds it from the file written by write().
+void ChromosomeTable::getIntToChromNameMap(map<int, string*>& mapOut) const
+{
+  for (unsigned int i = 0; i < m_namesInOrder.size(); i++)
+    mapOut[i + 1] = m_namesInOrder[i];
+}
+
+// Number of sites with each scaled -log10(P) value.  Nearly all scores are small,
+// so those get counted in a flat array; the rare larger ones (up to MAX_VALUE; see SiteManager) go in a map.
+// Histograms from independently processed parts of the input are combined with merge().
+class ScoreHistogram {
+public:
+  ScoreHistogram(void) : m_dense(DENSE_LIMIT, 0) {};
+  void add(const int& negLog10P_scaled, const long& numOccs);
+  void merge(const ScoreHistogram& other);
+  void write(ostream& os) const;
+  bool read(istream& is);
+  void addTo(vector<long>& hist) const;
+
+private:
+  ScoreHistogram(const ScoreHistogram&); // deny use of the copy constructor
+  static const int DENSE_LIMIT = 1 << 16;
+  vector<long> m_dense;
+  map<int, long> m_sparse;
+};
+
+inline void ScoreHistogram::add(const int& negLog10P_scaled, const long& numOccs)
+{
+  if (negLog10P_scaled < 0)
+    {
+      cerr << "Error:  line " << __LINE__ << ", received a negative score (" << negLog10P_scaled << ")"
+	   << endl << endl;
+      exit(2);
+    }
+  if (negLog10P_scaled < DENSE_LIMIT)
+    m_dense[negLog10P_scaled] += numOccs;
+  else
+    m_sparse[negLog10P_scaled] += numOccs;
+}
+
+void ScoreHistogram::merge(const ScoreHistogram& other)
+{
+  for (int i = 0; i < DENSE_LIMIT; i++)
+    m_dense[i] += other.m_dense[i];
+  for (map<int, long>::const_iterator it = other.m_sparse.begin(); it != other.m_sparse.end(); it++)
+    m_sparse[it->first] += it->second;
+}
+
+// Write "score \t numOccs" lines, in ascending order of score, for each score that occurred.
+void ScoreHistogram::write(ostream& os) const
+{
+  for (int i = 0; i < DENSE_LIMIT; i++)
+    {
+      if (m_dense[i] != 0)
+	os << i << '\t' << m_dense[i] << '\n';
+    }
+  for (map<int, long>::const_iterator it = m_sparse.begin(); it != m_sparse.end(); it++)
+    os << it->first << '\t' << it->second << '\n';
+}
+
+// Add the counts in a file written by write(); returns false if it's malformed.
+bool ScoreHistogram::read(istream& is)
+{
+  LineReader lines(is);
+  char* fields[2];
+
+  while (lines.next())
+    {
+      if (splitFields(lines.line(), lines.length(), '\t', fields, 2) != 2 || !*fields[0])
+	return false;
+      const int negLog10P_scaled(parseInt(fields[0]));
+      if (negLog10P_scaled < 0)
+	return false;
+      add(negLog10P_scaled, parseLong(fields[1]));
+    }
+
+  return true;
+}
+
+// Add the counts into a flat array indexed by score, as read by hotspot2_part2 (see hotspot2_fdr.h).
+void ScoreHistogram::addTo(vector<long>& hist) const
+{
+  int maxScore(-1);
+  if (!m_sparse.empty())
+    maxScore = m_sparse.rbegin()->first;
+  else
+    {
+      for (int i = DENSE_LIMIT - 1; i >= 0 && -1 == maxScore; i--)
+	{
+	  if (m_dense[i] != 0)
+	    maxScore = i;
+	}
+    }
+  if (maxScore >= static_cast<int>(hist.size()))
+    hist.resize(maxScore + 1, 0);
+  for (int i = 0; i < DENSE_LIMIT && i <= maxScore; i++)
+    hist[i] += m_dense[i];
+  for (map<int, long>::const_iterator it = m_sparse.begin(); it != m_sparse.end(); it++)
+    hist[it->first] += it->second;
+}
+
+struct SiteRange {
+  string* chrom;
+  string* ID;
+  long double pval;
+  //  long double qval;
+  long begPos;
+  long endPos;
+  int count;
+  int negLog10P_scaled; // -log10(P-value), scaled and rounded to limit the number of sig. digits
+  bool hasPval; // whether a P-value has been computed for the site range
+#ifdef DEBUG
+  bool sampled;
+#endif
+};
+
+long double nextProbNegativeBinomial(const int& k, const long double& prevVal, const vector<long double>& params);
+long double nextProbNegativeBinomial(const int& k, const long double& prevVal, const vector<long double>& params)
+{
+  if (params.size() < 2)
+    {
+      cerr << "Error:  nextProbNegativeBinomial() received an incorrect parameter vector; expected m, r."
+           << endl
+           << endl;
+      exit(1);
+    }
+  if (0 == k)
+    {
+      cerr << "Error:  nextProbNegativeBinomial() received k = 0, which is invalid (require k > 0)."
+           << endl
+           << endl;
+      exit(1);
+    }
+  const long double &m(params[0]), &r(params[1]), kk(static_cast<long double>(k));
+  if (r + m == 0)
+    {
+      cerr << "Error:  nextProbNegativeBinomial() received m = " << m
+           << " and r = " << r << ", which is invalid (require r+m > 0)."
+           << endl
+           << endl;
+      exit(1);
+    }
+  return prevVal * m * (r + kk - 1.) / ((r + m) * kk);
+}
+
+long double nextProbBinomial(const int& k, const long double& prevVal, const vector<long double>& params);
+long double nextProbBinomial(const int& k, const long double& prevVal, const vector<long double>& params)
+{
+  if (params.size() < 3)
+    {
+      cerr << "Error:  nextProbBinomial() received an incorrect parameter vector; expected m, v, n."
+           << endl
+           << endl;
+      exit(1);
+    }
+  if (0 == k)
+    {
+      cerr << "Error:  nextProbBinomial() received k = 0, which is invalid (require k > 0)."
+           << endl
+           << endl;
+      exit(1);
+    }
+  const long double &m(params[0]), &v(params[1]), &nn(params[2]), kk(static_cast<long double>(k));
+  if (kk > nn + 0.5) // really "if kk > nn," but we could have "kk == nn" with nn=15.99999 and kk=16.000001, hence the 0.5
+    return 0.;
+  if (v < 1.0e-8)
+    {
+      cerr << "Error:  nextProbBinomial() received v = 0, which is invalid (require variance > 0)."
+           << endl
+           << endl;
+      exit(1);
+    }
+  return prevVal * (m - v) * (nn + 1. - kk) / (v * kk);
+}
+
+long double nextProbPoisson(const int& k, const long double& prevVal, const vector<long double>& params);
+long double nextProbPoisson(const int& k, const long double& prevVal, const vector<long double>& params)
+{
+  if (params.empty())
+    {
+      cerr << "Error:  nextProbPoisson() received an incorrect parameter vector; expected m."
+           << endl
+           << endl;
+      exit(1);
+    }
+  if (0 == k)
+    {
+      cerr << "Error:  nextProbPoisson() received k = 0, which is invalid (require k > 0)."
+           << endl
+           << endl;
+      exit(1);
+    }
+  const long double &m(params[0]), kk(static_cast<long double>(k));
+  return prevVal * m / kk;
+}
+
+// The regularized incomplete beta function I_x(a,b) and lower incomplete gamma function P(a,x),
+// which give the upper tails of the null models in closed form (--closed-form-tails).
+// These follow betai()/betacf() and gammp()/gser()/gcf() in Numerical Recipes:  the series or continued fraction
+// is chosen so that it converges quickly, in O(sqrt(a)) iterations or fewer, and so that small tails are summed
+// directly rather than obtained as 1 minus something close to 1.
+const int INCOMPLETE_FN_MAX_ITERATIONS = 100000;
+const long double INCOMPLETE_FN_EPS = 1.0e-12;
+const long double INCOMPLETE_FN_TINY = 1.0e-4900L; // near the smallest normal long double
+
+// Continued fraction for I_x(a,b), evaluated by the modified Lentz method.
+long double incompleteBetaCF(const long double& a, const long double& b, const long double& x);
+long double incompleteBetaCF(const long double& a, const long double& b, const long double& x)
+{
+  const long double qab(a + b), qap(a + 1.), qam(a - 1.);
+  long double c(1.), d(1. - qab * x / qap);
+  if (fabs(d) < INCOMPLETE_FN_TINY)
+    d = INCOMPLETE_FN_TINY;
+  d = 1. / d;
+  long double h(d);
+  for (int i = 1; i <= INCOMPLETE_FN_MAX_ITERATIONS; i++)
+    {
+      const long double ii(static_cast<long double>(i)), i2(2. * ii);
+      long double aa = ii * (b - ii) * x / ((qam + i2) * (a + i2));
+      d = 1. + aa * d;
+      if (fabs(d) < INCOMPLETE_FN_TINY)
+        d = INCOMPLETE_FN_TINY;
+      c = 1. + aa / c;
+      if (fabs(c) < INCOMPLETE_FN_TINY)
+        c = INCOMPLETE_FN_TINY;
+      d = 1. / d;
+      h *= d * c;
+      aa = -(a + ii) * (qab + ii) * x / ((a + i2) * (qap + i2));
+      d = 1. + aa * d;
+      if (fabs(d) < INCOMPLETE_FN_TINY)
+        d = INCOMPLETE_FN_TINY;
+      c = 1. + aa / c;
+      if (fabs(c) < INCOMPLETE_FN_TINY)
+        c = INCOMPLETE_FN_TINY;
+      d = 1. / d;
+      const long double del(d * c);
+      h *= del;
+      if (fabs(del - 1.) < INCOMPLETE_FN_EPS)
+        break;
+    }
+  return h;
+}
+
+long double regularizedIncompleteBeta(const long double& a, const long double& b, const long double& x);
+long double regularizedIncompleteBeta(const long double& a, const long double& b, const long double& x)
+{
+  if (x <= 0)
+    return 0.;
+  if (x >= 1.)
+    return 1.;
+  int sign; // lgammal_r() rather than lgammal(), which sets a global variable, because this can run on multiple threads
+  const long double front(exp(lgammal_r(a + b, &sign) - lgammal_r(a, &sign) - lgammal_r(b, &sign)
+                              + a * log(x) + b * log1pl(-x)));
+  if (x < (a + 1.) / (a + b + 2.))
+    return front * incompleteBetaCF(a, b, x) / a;
+  return 1. - front * incompleteBetaCF(b, a, 1. - x) / b;
+}
+
+long double regularizedLowerIncompleteGamma(const long double& a, const long double& x);
+long double regularizedLowerIncompleteGamma(const long double& a, const long double& x)
+{
+  if (x <= 0)
+    return 0.;
+  int sign;
+  const long double front(exp(a * log(x) - x - lgammal_r(a, &sign)));
+  if (x < a + 1.)
+    {
+      // series
+      long double ap(a), del(1. / a), sum(del);
+      for (int i = 1; i <= INCOMPLETE_FN_MAX_ITERATIONS; i++)
+        {
+          ap += 1.;
+          del *= x / ap;
+          sum += del;
+          if (fabs(del) < fabs(sum) * INCOMPLETE_FN_EPS)
+            break;
+        }
+      return front * sum;
+    }
+  // continued fraction for the upper tail, by the modified Lentz method
+  long double b(x + 1. - a), c(1. / INCOMPLETE_FN_TINY), d(1. / b), h(d);
+  for (int i = 1; i <= INCOMPLETE_FN_MAX_ITERATIONS; i++)
+    {
+      const long double ii(static_cast<long double>(i)), an(-ii * (ii - a));
+      b += 2.;
+      d = an * d + b;
+      if (fabs(d) < INCOMPLETE_FN_TINY)
+        d = INCOMPLETE_FN_TINY;
+      c = b + an / c;
+      if (fabs(c) < INCOMPLETE_FN_TINY)
+        c = INCOMPLETE_FN_TINY;
+      d = 1. / d;
+      const long double del(d * c);
+      h *= del;
+      if (fabs(del - 1.) < INCOMPLETE_FN_EPS)
+        break;
+    }
+  return 1. - front * h;
+}
+
+// P(X >= k) for k > 0, with the parameters used by the corresponding nextProb*() function above.
+long double upperTailNegativeBinomial(const int& k, const vector<long double>& params);
+long double upperTailNegativeBinomial(const int& k, const vector<long double>& params)
+{
+  const long double &m(params[0]), &r(params[1]);
+  return regularizedIncompleteBeta(static_cast<long double>(k), r, m / (r + m));
+}
+
+long double upperTailBinomial(const int& k, const vector<long double>& params);
+long double upperTailBinomial(const int& k, const vector<long double>& params)
+{
+  const long double &m(params[0]), &v(params[1]), &nn(params[2]), kk(static_cast<long double>(k));
+  if (kk > nn + 0.5) // see nextProbBinomial()
+    return 0.;
+  return regularizedIncompleteBeta(kk, nn - kk + 1., 1. - v / m);
+}
+
+long double upperTailPoisson(const int& k, const vector<long double>& params);
+long double upperTailPoisson(const int& k, const vector<long double>& params)
+{
+  return regularizedLowerIncompleteGamma(static_cast<long double>(k), params[0]);
+}
+
+// Double-precision form of the three recursions above, used with --double-precision.
+// For each model, pmf(k) = pmf(k-1) * (A + B*k)/k, with pmf(k) = 0 for k > kMax (binomial only),
+// so a single set of coefficients describes all three.  Unlike the long double functions,
+// these are called directly, on blocks of k values, rather than once per k via a function pointer.
+struct PmfCoefficients {
+  double A;
+  double B;
+  int kMax;
+};
+
+// ratios[i] = pmf(kBegin+i) / pmf(kBegin+i-1), for 0 <= i < n.
+// There's no dependency or branch within the first loop, so the compiler vectorizes it.
+inline void pmfRatios(const PmfCoefficients& c, const int& kBegin, const int& n, double* ratios)
+{
+  const double A(c.A), B(c.B);
+  for (int i = 0; i < n; i++)
+    {
+      const double kk(static_cast<double>(kBegin + i));
+      ratios[i] = (A + B * kk) / kk;
+    }
+  for (int i = max(c.kMax + 1 - kBegin, 0); i < n; i++) // only nonempty for the binomial
+    ratios[i] = 0.;
+}
+
+// Returns pval(k)/pmf(k), i.e., 1 + term(k+1) + term(k+2) + ..., with the terms relative to pmf(k)
+// and the sum capped as in BackgroundRegionManager::computeStats().
+// The ratios are computed 8 at a time; only the running product is serial.
+inline double tailFactor(const PmfCoefficients& c, const int& k)
+{
+  const int BLOCK_SIZE(8);
+  const double SMALL_VALUE(5.0e-7);
+  double ratios[BLOCK_SIZE], sum(1.), term(1.);
+  for (int kBegin = k + 1; ; kBegin += BLOCK_SIZE)
+    {
+      pmfRatios(c, kBegin, BLOCK_SIZE, ratios);
+      for (int i = 0; i < BLOCK_SIZE; i++)
+        {
+          term *= ratios[i];
+          if (term <= SMALL_VALUE)
+            return sum;
+          sum += term;
+        }
+    }
+}
+
+// The score that gets written out for a P-value:  -log10(P), scaled and rounded.
+// A P-value that isn't a number (e.g., from a degenerate null model) scores 0, as one outside [0,1] does.
+inline int scaledNegLog10P(const long double& pval)
+{
+  static const int MAX_VALUE = static_cast<int>(floor(-log10(numeric_limits<long double>::min()) * CHANGE_OF_SCALE + 0.5));
+  if (!(pval >= 0 && pval <= 1))
+    return 0;
+  if (pval < numeric_limits<long double>::min())
+    return MAX_VALUE;
+  return static_cast<int>(floor(-log10(pval) * CHANGE_OF_SCALE + 0.5));
+}
+
+// For --verify-precision:  tallies how the scores of P-values from the double-precision kernels
+// differ from those of the long double P-values that get written out.
+class PrecisionCheck {
+public:
+  PrecisionCheck(void);
+  ~PrecisionCheck(void) { pthread_mutex_destroy(&m_mutex); };
+  void compare(const long double& pval, const long double& pvalDouble);
+  void merge(const PrecisionCheck& other); // thread-safe
+  void report(ostream& os) const;
+
+private:
+  PrecisionCheck(const PrecisionCheck&); // deny use of the copy constructor
+  long m_numCompared;
+  long m_numDiffering;
+  int m_maxDiff;
+  long double m_pvalAtMaxDiff;
+  long double m_pvalDoubleAtMaxDiff;
+  pthread_mutex_t m_mutex;
+};
+
+PrecisionCheck::PrecisionCheck(void)
+  : m_numCompared(0), m_numDiffering(0), m_maxDiff(0), m_pvalAtMaxDiff(-1.), m_pvalDoubleAtMaxDiff(-1.)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+}
+
+inline void PrecisionCheck::compare(const long double& pval, const long double& pvalDouble)
+{
+  const int diff(abs(scaledNegLog10P(pval) - scaledNegLog10P(pvalDouble)));
+  m_numCompared++;
+  if (0 == diff)
+    return;
+  m_numDiffering++;
+  if (diff > m_maxDiff)
+    {
+      m_maxDiff = diff;
+      m_pvalAtMaxDiff = pval;
+      m_pvalDoubleAtMaxDiff = pvalDouble;
+    }
+}
+
+void PrecisionCheck::merge(const PrecisionCheck& other)
+{
+  pthread_mutex_lock(&m_mutex);
+  m_numCompared += other.m_numCompared;
+  m_numDiffering += other.m_numDiffering;
+  if (other.m_maxDiff > m_maxDiff)
+    {
+      m_maxDiff = other.m_maxDiff;
+      m_pvalAtMaxDiff = other.m_pvalAtMaxDiff;
+      m_pvalDoubleAtMaxDiff = other.m_pvalDoubleAtMaxDiff;
+    }
+  pthread_mutex_unlock(&m_mutex);
+}
+
+void PrecisionCheck::report(ostream& os) const
+{
+  os << "Precision check:  " << m_numDiffering << " of " << m_numCompared
+     << " P-value lookups gave a different score with the double-precision kernels." << endl;
+  if (m_maxDiff > 0)
+    os << "Largest difference in score (-log10(P) * " << CHANGE_OF_SCALE << "):  " << m_maxDiff
+       << ", for P = " << m_pvalAtMaxDiff << " (long double) vs. " << m_pvalDoubleAtMaxDiff << " (double)." << endl;
+}
+
+// The statistics a null model is fitted to.  The fit is a function of these alone,
+// except that the binomial's n can be raised to the cutoff (see computeStats()),
+// so kcutoff is part of the key for binomial fits, and -1 otherwise.
+struct NullModelKey {
+  long sum;
+  long sumSq;
+  int N;
+  int kcutoff;
+  bool operator<(const NullModelKey& other) const {
+    if (sum != other.sum)
+      return sum < other.sum;
+    if (sumSq != other.sumSq)
+      return sumSq < other.sumSq;
+    if (N != other.N)
+      return N < other.N;
+    return kcutoff < other.kcutoff;
+  };
+};
+
+// The pmfs computed for a fit so far, pmf[k] for 0 <= k < pmf.size(),
+// and where the P-value floor (--min-pvalue) was reached, if it was.
+struct NullModelTable {
+  NullModelTable(void) : kFloor(-1), pvalAtFloor(-1.) {};
+  vector<long double> pmf;
+  int kFloor;
+  long double pvalAtFloor;
+};
+
+// Hit and miss counts for the caches of null-model tables (--table-cache-stats).
+class NullModelCacheStats {
+public:
+  NullModelCacheStats(void);
+  ~NullModelCacheStats(void) { pthread_mutex_destroy(&m_mutex); };
+  void merge(const NullModelCacheStats& other); // thread-safe
+  void report(ostream& os) const;
+  long numHits;
+  long numMisses;
+  long numEvictions;
+
+private:
+  NullModelCacheStats(const NullModelCacheStats&); // deny use of the copy constructor
+  pthread_mutex_t m_mutex;
+};
+
+NullModelCacheStats::NullModelCacheStats(void)
+  : numHits(0), numMisses(0), numEvictions(0)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+}
+
+void NullModelCacheStats::merge(const NullModelCacheStats& other)
+{
+  pthread_mutex_lock(&m_mutex);
+  numHits += other.numHits;
+  numMisses += other.numMisses;
+  numEvictions += other.numEvictions;
+  pthread_mutex_unlock(&m_mutex);
+}
+
+void NullModelCacheStats::report(ostream& os) const
+{
+  const long numLookups(numHits + numMisses);
+  os << "Null-model table cache:  " << numHits << " hits, " << numMisses << " misses ("
+     << (numLookups > 0 ? 100. * static_cast<double>(numHits) / static_cast<double>(numLookups) : 0.)
+     << "% hit rate), " << numEvictions << " evictions." << endl;
+}
+
+// Wall-clock time in seconds, for timing (--stats).
+inline double wallClockSeconds(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<double>(tv.tv_sec) + 1.0e-6 * static_cast<double>(tv.tv_usec);
+}
+
+// Counts of the work done in the hot path, and the time spent on each chromosome (--stats).
+// Each background region manager counts its calls and pmf evaluations, each site feeder times its chromosomes,
+// and each merges its tallies into the run's total upon destruction.
+class RunStats {
+public:
+  // What prompted a call to findCutoff().
+  enum CutoffTrigger { CUTOFF_AT_FLUSH, CUTOFF_AT_WINDOW_START, CUTOFF_IN_GAP, CUTOFF_ON_SLIDE, NUM_CUTOFF_TRIGGERS };
+  // What prompted a call to computeStats():  a flush or a new window (all pmfs), a change in the null model
+  // while sliding (pmfs through the central site's count), or a central count beyond the pmfs computed so far.
+  enum FitTrigger { FIT_AT_FLUSH, FIT_AT_WINDOW_START, FIT_ON_CHANGE, FIT_EXTENSION, NUM_FIT_TRIGGERS };
+  RunStats(void);
+  ~RunStats(void) { pthread_mutex_destroy(&m_mutex); };
+  void noteDistnSize(const size_t& n) { if (static_cast<long>(n) > maxDistnSize) maxDistnSize = static_cast<long>(n); };
+  void addChromTime(const string* chrom, const long& numSites, const double& seconds);
+  void merge(const RunStats& other); // thread-safe
+  void writeJSON(ostream& os, const ChromosomeTable& chroms, const double& elapsedSeconds) const;
+  long numFindCutoffCalls[NUM_CUTOFF_TRIGGERS];
+  long numComputeStatsCalls[NUM_FIT_TRIGGERS];
+  long numPmfTerms; // pmfs evaluated, in either precision
+  long numTailSumTerms; // terms evaluated by tailSum()
+  long numDistnExtensions; // calls to getPvalue() that had to add bins to the count distribution
+  long numBinsFromExtensions; // bins those calls needed to reach the count looked up
+  long numFlushes;
+  long maxDistnSize;
+  long numVerifications; // windows checked against a recomputation from scratch (--verify)
+
+private:
+  RunStats(const RunStats&); // deny use of the copy constructor
+  struct ChromTime {
+    ChromTime(void) : numSites(0), seconds(0.) {};
+    long numSites;
+    double seconds; // summed over threads, if the chromosome was split into chunks
+  };
+  map<const string*, ChromTime> m_chromTimes; // keyed by the interned names
+  pthread_mutex_t m_mutex;
+};
+
+RunStats::RunStats(void)
+  : numPmfTerms(0), numTailSumTerms(0), numDistnExtensions(0), numBinsFromExtensions(0), numFlushes(0), maxDistnSize(0),
+    numVerifications(0)
+{
+  for (int i = 0; i < NUM_CUTOFF_TRIGGERS; i++)
+    numFindCutoffCalls[i] = 0;
+  for (int i = 0; i < NUM_FIT_TRIGGERS; i++)
+    numComputeStatsCalls[i] = 0;
+  pthread_mutex_init(&m_mutex, NULL);
+}
+
+void RunStats::addChromTime(const string* chrom, const long& numSites, const double& seconds)
+{
+  ChromTime& t(m_chromTimes[chrom]);
+  t.numSites += numSites;
+  t.seconds += seconds;
+}
+
+void RunStats::merge(const RunStats& other)
+{
+  pthread_mutex_lock(&m_mutex);
+  for (int i = 0; i < NUM_CUTOFF_TRIGGERS; i++)
+    numFindCutoffCalls[i] += other.numFindCutoffCalls[i];
+  for (int i = 0; i < NUM_FIT_TRIGGERS; i++)
+    numComputeStatsCalls[i] += other.numComputeStatsCalls[i];
+  numPmfTerms += other.numPmfTerms;
+  numTailSumTerms += other.numTailSumTerms;
+  numDistnExtensions += other.numDistnExtensions;
+  numBinsFromExtensions += other.numBinsFromExtensions;
+  numFlushes += other.numFlushes;
+  numVerifications += other.numVerifications;
+  noteDistnSize(static_cast<size_t>(other.maxDistnSize));
+  for (map<const string*, ChromTime>::const_iterator it = other.m_chromTimes.begin(); it != other.m_chromTimes.end(); it++)
+    addChromTime(it->first, it->second.numSites, it->second.seconds);
+  pthread_mutex_unlock(&m_mutex);
+}
+
+// Chromosomes are listed in order of first appearance in the input.
+void RunStats::writeJSON(ostream& os, const ChromosomeTable& chroms, const double& elapsedSeconds) const
+{
+  static const char* cutoffTriggerNames[NUM_CUTOFF_TRIGGERS] = { "flush", "window_start", "gap", "slide" };
+  static const char* fitTriggerNames[NUM_FIT_TRIGGERS] = { "flush", "window_start", "model_change", "extension" };
+  long total(0), numSites(0);
+
+  os << "{\n"
+     << "  \"elapsed_seconds\": " << elapsedSeconds << ",\n"
+     << "  \"find_cutoff_calls\": {";
+  for (int i = 0; i < NUM_CUTOFF_TRIGGERS; i++)
+    {
+      os << " \"" << cutoffTriggerNames[i] << "\": " << numFindCutoffCalls[i] << ',';
+      total += numFindCutoffCalls[i];
+    }
+  os << " \"total\": " << total << " },\n"
+     << "  \"compute_stats_calls\": {";
+  total = 0;
+  for (int i = 0; i < NUM_FIT_TRIGGERS; i++)
+    {
+      os << " \"" << fitTriggerNames[i] << "\": " << numComputeStatsCalls[i] << ',';
+      total += numComputeStatsCalls[i];
+    }
+  os << " \"total\": " << total << " },\n"
+     << "  \"pmf_terms\": " << numPmfTerms << ",\n"
+     << "  \"tail_sum_terms\": " << numTailSumTerms << ",\n"
+     << "  \"pvalue_extensions\": { \"calls\": " << numDistnExtensions << ", \"bins_added\": " << numBinsFromExtensions << " },\n"
+     << "  \"window_flushes\": " << numFlushes << ",\n"
+     << "  \"max_distn_size\": " << maxDistnSize << ",\n"
+     << "  \"verifications\": " << numVerifications << ",\n"
+     << "  \"chromosomes\": [";
+
+  map<int, string*> chromNames;
+  chroms.getIntToChromNameMap(chromNames);
+  bool first(true);
+  for (map<int, string*>::const_iterator itName = chromNames.begin(); itName != chromNames.end(); itName++)
+    {
+      map<const string*, ChromTime>::const_iterator it = m_chromTimes.find(itName->second);
+      if (m_chromTimes.end() == it)
+        continue;
+      const ChromTime& t(it->second);
+      os << (first ? "\n" : ",\n") << "    { \"name\": \"";
+      for (string::const_iterator ch = it->first->begin(); ch != it->first->end(); ch++)
+        {
+          if ('"' == *ch || '\\' == *ch)
+            os << '\\' << *ch;
+          else if (static_cast<unsigned char>(*ch) < 0x20)
+            os << ' ';
+          else
+            os << *ch;
+        }
+      os << "\", \"sites\": " << t.numSites << ", \"seconds\": " << t.seconds
+         << ", \"sites_per_second\": " << (t.seconds > 0 ? static_cast<long>(static_cast<double>(t.numSites) / t.seconds + 0.5) : 0L) << " }";
+      numSites += t.numSites;
+      first = false;
+    }
+  os << (first ? "],\n" : "\n  ],\n")
+     << "  \"sites\": " << numSites << ",\n"
+     << "  \"sites_per_second\": " << (elapsedSeconds > 0 ? static_cast<long>(static_cast<double>(numSites) / elapsedSeconds + 0.5) : 0L) << "\n"
+     << "}" << endl;
+}
+
+// As the background window slides, its running sums often return to recently seen values.
+// Each background region manager keeps the tables of its most recently used fits here,
+// so that a fit that recurs takes its pmfs from the table instead of recomputing them from k = 0.
+// When the cache is full, the least recently used table is evicted.
+class NullModelCache {
+public:
+  NullModelCache(const int& capacity) : m_capacity(capacity) {};
+  NullModelTable* find(const NullModelKey& key); // returns NULL if key isn't cached
+  NullModelTable* insert(const NullModelKey& key); // returns an empty table for a key that isn't cached
+  const NullModelCacheStats& getStats(void) const { return m_stats; };
+
+private:
+  NullModelCache(void); // require use of the constructor with 1 argument
+  NullModelCache(const NullModelCache&); // ditto
+  typedef list<pair<NullModelKey, NullModelTable> > LRUlist;
+  int m_capacity;
+  LRUlist m_tables; // most recently used first
+  map<NullModelKey, LRUlist::iterator> m_index;
+  NullModelCacheStats m_stats;
+};
+
+NullModelTable* NullModelCache::find(const NullModelKey& key)
+{
+  map<NullModelKey, LRUlist::iterator>::iterator it = m_index.find(key);
+  if (m_index.end() == it)
+    {
+      m_stats.numMisses++;
+      return NULL;
+    }
+  m_stats.numHits++;
+  m_tables.splice(m_tables.begin(), m_tables, it->second); // iterators remain valid
+  return &m_tables.front().second;
+}
+
+NullModelTable* NullModelCache::insert(const NullModelKey& key)
+{
+  if (static_cast<int>(m_tables.size()) < m_capacity)
+    m_tables.push_front(make_pair(key, NullModelTable()));
+  else
+    {
+      // Reuse the least recently used entry, and the memory its pmfs occupied.
+      m_index.erase(m_tables.back().first);
+      m_tables.splice(m_tables.begin(), m_tables, --m_tables.end());
+      m_tables.front().first = key;
+      NullModelTable& t(m_tables.front().second);
+      t.pmf.clear();
+      t.kFloor = -1;
+      t.pvalAtFloor = -1.;
+      m_stats.numEvictions++;
+    }
+  m_index[key] = m_tables.begin();
+  return &m_tables.front().second;
+}
+
+// Null-model settings shared by every background region manager in a run.
+struct NullModelSettings {
+  NullModelSettings(void) : samplingInterval(1), MAlength(5), minPvalue(0.), closedFormTails(false), doubleKernels(false),
+			    pPrecisionCheck(NULL), tableCacheSize(0), pTableCacheStats(NULL), pRunStats(NULL), verifyInterval(0) {};
+  int samplingInterval;
+  int MAlength;
+  long double minPvalue; // smaller P-values are reported as this value (--min-pvalue); 0 means no floor
+  bool closedFormTails; // compute each P-value on demand, in closed form, instead of from pmfs (--closed-form-tails)
+  bool doubleKernels; // compute pmfs and P-values in double precision (--double-precision)
+  PrecisionCheck* pPrecisionCheck; // if not NULL, also run the double kernels and tally the differences (--verify-precision)
+  int tableCacheSize; // number of null-model tables each background region manager keeps (--table-cache); 0 disables the cache
+  NullModelCacheStats* pTableCacheStats; // if not NULL, receives the caches' hit and miss counts
+  RunStats* pRunStats; // if not NULL, receives the counts of work done and the time per chromosome (--stats)
+  int verifyInterval; // every this many slides, check the sliding statistics against a recomputation (--verify); 0 disables
+};
+
+// Compact record of contiguous sites that are awaiting P-values, or of an output range that has one
+// and hasn't yet been written out (because the site after it might have the same scaled P-value and extend it).
+struct PendingSite {
+  const string* chrom;
+  long begPos;
+  long endPos;
+  int negLog10P_scaled;
+  bool hasPval;
+#ifdef DEBUG
+  bool sampled;
+#endif
+};
+
+// Sites are added in genomic order, and P-values arrive for them in the same order.
+// The sites awaiting P-values are held in a circular buffer, with contiguous ones on the same chromosome
+// sharing an entry, so a run of sites can be added, and given a P-value, in one call.
+// Sites that have a P-value are merged into the output range that's yet to be written (m_unreported),
+// or begin the next one, so handing off a P-value takes constant time, however many sites it's for.
+class SiteManager {
+public:
+  SiteManager(ostream& os, ScoreHistogram& hist, const ChromosomeTable& chroms, const int& initialCapacity,
+	      const bool& binaryOutput);
+  void addSite(const SiteRange& s); // the sites s.begPos+1 through s.endPos
+  void processPvalue(const long double& pval
+#ifdef DEBUG
+		     , const bool& sampled
+#endif
+		     ) { processPvalues(pval, 1
+#ifdef DEBUG
+				       , sampled
+#endif
+				       ); };
+  void processPvalues(const long double& pval, long numSites
+#ifdef DEBUG
+		      , const bool& sampled
+#endif
+		      );
+  void writeLastUnreportedSite();
+
+private:
+  SiteManager(); // require the above constructor to be used
+  SiteManager(const SiteManager&); // deny use of the copy constructor
+  //  void initialize(ofstream& ofsJustPvals);
+  PendingSite& at(const unsigned long& i) { return m_sites[(m_head + i) & m_mask]; };
+  void grow(void);
+  vector<PendingSite> m_sites; // circular buffer; its capacity is a power of 2
+  unsigned long m_mask; // m_sites.size() - 1
+  unsigned long m_head; // slot of the oldest entry
+  unsigned long m_numSites; // number of entries
+  PendingSite m_unreported; // the output range that's yet to be written, if hasPval == true
+  ostream& m_os;
+  ScoreHistogram& m_hist; // scores of the output ranges, weighted by width
+  const ChromosomeTable& m_chroms;
+  bool m_binaryOutput; // write records in the format of hotspot2_intermediate.h instead of text
+};
+
+// initialCapacity should be the background window size; about half a window of sites await P-values at any time.
+SiteManager::SiteManager(ostream& os, ScoreHistogram& hist, const ChromosomeTable& chroms, const int& initialCapacity,
+			 const bool& binaryOutput)
+  : m_os(os), m_hist(hist), m_chroms(chroms), m_binaryOutput(binaryOutput)
+{
+  unsigned long capacity(16);
+  while (capacity < static_cast<unsigned long>(initialCapacity) + 2)
+    capacity *= 2;
+  m_sites.resize(capacity);
+  m_mask = capacity - 1;
+  m_head = m_numSites = 0;
+  m_unreported.chrom = NULL;
+  m_unreported.hasPval = false;
+}
+
+void SiteManager::grow(void)
+{
+  vector<PendingSite> bigger(2 * m_sites.size());
+  for (unsigned long i = 0; i < m_numSites; i++)
+    bigger[i] = at(i);
+  m_sites.swap(bigger);
+  m_mask = m_sites.size() - 1;
+  m_head = 0;
+}
+
+void SiteManager::addSite(const SiteRange& s)
+{
+  if (m_numSites != 0)
+    {
+      PendingSite& back = at(m_numSites - 1);
+      if (back.chrom == s.chrom && back.endPos == s.begPos)
+	{
+	  back.endPos = s.endPos;
+	  return;
+	}
+    }
+  if (m_numSites == m_sites.size())
+    grow();
+  PendingSite& ps = at(m_numSites++);
+  ps.chrom = s.chrom;
+  ps.begPos = s.begPos;
+  ps.endPos = s.endPos;
+  ps.hasPval = false;
+}
+
+inline void SiteManager::writeLastUnreportedSite()
+{
+  if (m_unreported.hasPval)
+    {
+      const PendingSite& front = m_unreported;
+      m_unreported.hasPval = false;
+      m_hist.add(front.negLog10P_scaled, front.endPos - front.begPos);
+      if (m_binaryOutput)
+	{
+	  char buf[HOTSPOT2_INTERMEDIATE_RECORD_SIZE];
+	  encodeIntermediateRecord(buf, m_chroms.idxFromChrom(front.chrom), front.begPos,
+				   front.endPos - front.begPos, front.negLog10P_scaled);
+	  m_os.write(buf, HOTSPOT2_INTERMEDIATE_RECORD_SIZE);
+	  return;
+	}
+      m_os << m_chroms.idxFromChrom(front.chrom) << '\t'
+	   << front.begPos << '\t'
+	   << front.endPos - front.begPos << '\t'
+	   << front.negLog10P_scaled;
+#ifdef DEBUG
+      m_os << '\t' << front.sampled;
+#endif
+      m_os << '\n';
+    }
+}
+
+
+// The next numSites sites awaiting P-values all get this one.
+void SiteManager::processPvalues(const long double& pval, long numSites
+#ifdef DEBUG
+				 , const bool& sampled
+#endif
+				 )
+{
+  const int negLog10P_scaled(scaledNegLog10P(pval));
+  while (numSites > 0)
+    {
+      if (0 == m_numSites)
+	{
+	  cerr << "Error:  line " << __LINE__ << ", m_sites is empty or already filled with P-values"
+	       << endl << endl;
+	  exit(2);
+	}
+      PendingSite& cur = at(0);
+      const long n(min(numSites, cur.endPos - cur.begPos));
+
+      // Either these sites extend the unreported output range, or that range is complete and gets written.
+      if (m_unreported.hasPval && m_unreported.chrom == cur.chrom && m_unreported.endPos == cur.begPos &&
+#ifdef DEBUG
+	  m_unreported.sampled == sampled &&
+#endif
+	  m_unreported.negLog10P_scaled == negLog10P_scaled)
+	m_unreported.endPos += n;
+      else
+	{
+	  writeLastUnreportedSite();
+	  m_unreported.chrom = cur.chrom;
+	  m_unreported.begPos = cur.begPos;
+	  m_unreported.endPos = cur.begPos + n;
+	  m_unreported.negLog10P_scaled = negLog10P_scaled;
+	  m_unreported.hasPval = true;
+#ifdef DEBUG
+	  m_unreported.sampled = sampled;
+#endif
+	}
+
+      cur.begPos += n;
+      numSites -= n;
+      if (cur.begPos == cur.endPos)
+	{
+	  m_head = (m_head + 1) & m_mask;
+	  m_numSites--;
+	}
+    }
+}
+
+struct SiteData {
+  int pos;
+  int count;
+  bool hasPval;
+  bool sampled;
+};
+
+// The sites in the background window, in genomic order, held in one circular buffer
+// that's split at the window's central position into a left half [m_head, m_centre)
+// and a right half [m_centre, m_tail).  Sites enter at the right, leave at the left,
+// and cross from the right half into the left half as the window slides,
+// so each of these is an index increment, with no allocation once the buffer has been sized to the window.
+// The front of an empty half is a sentinel site at position -1, which never matches a window position.
+class BackgroundSites {
+public:
+  BackgroundSites(void);
+  void reserve(const int& windowSize);
+  bool leftEmpty(void) const { return m_head == m_centre; };
+  bool rightEmpty(void) const { return m_centre == m_tail; };
+  unsigned long leftSize(void) const { return m_centre - m_head; };
+  unsigned long size(void) const { return m_tail - m_head; };
+  SiteData& at(const unsigned long& i) { return m_sites[(m_head + i) & m_mask]; }; // i-th site from the left edge
+  SiteData& leftFront(void) { return leftEmpty() ? m_none : m_sites[m_head & m_mask]; };
+  SiteData& rightFront(void) { return rightEmpty() ? m_none : m_sites[m_centre & m_mask]; };
+  SiteData& rightBack(void) { return rightEmpty() ? m_none : m_sites[(m_tail - 1) & m_mask]; };
+  void pushLeft(const SiteData& sd);
+  void pushRight(const SiteData& sd);
+  void popLeft(void) { m_head++; };
+  void popLeft(const unsigned long& n) { m_head += n; };
+  void advanceCentre(void) { m_centre++; }; // moves the front of the right half onto the back of the left half
+  void advanceCentre(const unsigned long& n) { m_centre += n; };
+  void clear(void) { m_head = m_centre = m_tail = 0; };
+
+private:
+  BackgroundSites(const BackgroundSites&); // deny use of the copy constructor
+  void grow(void);
+  vector<SiteData> m_sites; // circular buffer; its capacity is a power of 2
+  unsigned long m_mask; // m_sites.size() - 1
+  unsigned long m_head; // these three only increase; they're masked when used as slots
+  unsigned long m_centre;
+  unsigned long m_tail;
+  SiteData m_none;
+};
+
+BackgroundSites::BackgroundSites(void)
+{
+  m_mask = m_head = m_centre = m_tail = 0;
+  m_sites.resize(1);
+  m_none.pos = m_none.count = -1;
+  m_none.hasPval = m_none.sampled = false;
+}
+
+// A window of windowSize bp holds at most windowSize sites, plus the incoming one during a slide.
+// This must only be called while the buffer is empty, i.e., between background windows.
+void BackgroundSites::reserve(const int& windowSize)
+{
+  unsigned long capacity(16);
+  while (capacity < static_cast<unsigned long>(windowSize) + 2)
+    capacity *= 2;
+  if (capacity > m_sites.size())
+    {
+      m_sites.resize(capacity);
+      m_mask = capacity - 1;
+    }
+  clear();
+}
+
+// Only needed if reserve() was given too small a window,
+// or when the window is so small that its central position is its left edge (-b 2),
+// in which case sites are never popped from the left half.
+void BackgroundSites::grow(void)
+{
+  vector<SiteData> bigger(2 * m_sites.size());
+  const unsigned long n(size()), nLeft(leftSize());
+  for (unsigned long i = 0; i < n; i++)
+    bigger[i] = at(i);
+  m_sites.swap(bigger);
+  m_mask = m_sites.size() - 1;
+  m_head = 0;
+  m_centre = nLeft;
+  m_tail = n;
+}
+
+// Sites in the left half are all added before any in the right half.
+inline void BackgroundSites::pushLeft(const SiteData& sd)
+{
+  if (size() == m_sites.size())
+    grow();
+  m_sites[m_tail & m_mask] = sd;
+  m_centre = ++m_tail;
+}
+
+inline void BackgroundSites::pushRight(const SiteData& sd)
+{
+  if (size() == m_sites.size())
+    grow();
+  m_sites[m_tail & m_mask] = sd;
+  m_tail++;
+}
+
+// Segment tree holding the minimum and maximum of each power-of-2-aligned range of an array of ints
+// (in practice, the moving averages of a CountDistribution), so that findCutoff() can locate
+// the first trend reversal beyond the mode, and the last minimum preceding it, in O(log K) time
+// rather than by scanning the K moving averages.  Node 1 is the root, node i's children are 2i and 2i+1,
+// and the leaves are nodes m_numLeaves through 2*m_numLeaves - 1.  Leaves that haven't been set hold -1.
+class MinMaxTree {
+public:
+  MinMaxTree(void);
+  void set(const int& i, const int& val);
+  void assign(const vector<int>& vals);
+  int firstTrendReversal(const int& lo, const int& hi, const long double& ratio, int& runningMin) const;
+  int lastAtMost(const int& lo, const int& hi, const int& val) const;
+
+private:
+  MinMaxTree(const MinMaxTree&); // deny use of the copy constructor
+  void resize(const int& minNumLeaves);
+  int firstTrendReversal(const int& node, const int& nodeL, const int& nodeR, const int& lo, const int& hi,
+                         const long double& ratio, int& runningMin) const;
+  int lastAtMost(const int& node, const int& nodeL, const int& nodeR, const int& lo, const int& hi, const int& val) const;
+  vector<int> m_min;
+  vector<int> m_max;
+  int m_numLeaves; // a power of 2
+};
+
+MinMaxTree::MinMaxTree(void)
+{
+  m_numLeaves = 0;
+  resize(16);
+}
+
+// Grows the tree to hold at least minNumLeaves leaves, keeping the current leaves' values.
+void MinMaxTree::resize(const int& minNumLeaves)
+{
+  int numLeaves(m_numLeaves > 0 ? m_numLeaves : 1);
+  while (numLeaves < minNumLeaves)
+    numLeaves *= 2;
+  vector<int> leaves(numLeaves, -1);
+  for (int i = 0; i < m_numLeaves; i++)
+    leaves[i] = m_min[m_numLeaves + i];
+  m_numLeaves = numLeaves;
+  assign(leaves);
+}
+
+void MinMaxTree::assign(const vector<int>& vals)
+{
+  if (static_cast<int>(vals.size()) > m_numLeaves)
+    {
+      m_numLeaves = 0;
+      resize(static_cast<int>(vals.size()));
+      return;
+    }
+  m_min.assign(2 * m_numLeaves, -1);
+  m_max.assign(2 * m_numLeaves, -1);
+  for (int i = 0; i < static_cast<int>(vals.size()); i++)
+    m_min[m_numLeaves + i] = m_max[m_numLeaves + i] = vals[i];
+  for (int node = m_numLeaves - 1; node > 0; node--)
+    {
+      m_min[node] = min(m_min[2 * node], m_min[2 * node + 1]);
+      m_max[node] = max(m_max[2 * node], m_max[2 * node + 1]);
+    }
+}
+
+// Updates the ancestors of leaf i until reaching one whose extrema don't change,
+// which for the +/-1 updates made while sliding is usually the leaf's parent or grandparent.
+inline void MinMaxTree::set(const int& i, const int& val)
+{
+  if (i >= m_numLeaves)
+    resize(i + 1);
+  int node = m_numLeaves + i;
+  m_min[node] = m_max[node] = val;
+  for (node /= 2; node > 0; node /= 2)
+    {
+      const int mn = min(m_min[2 * node], m_min[2 * node + 1]);
+      const int mx = max(m_max[2 * node], m_max[2 * node + 1]);
+      if (mn == m_min[node] && mx == m_max[node])
+        break;
+      m_min[node] = mn;
+      m_max[node] = mx;
+    }
+}
+
+// Returns the first i in [lo, hi] whose value is 0 or exceeds ratio times runningMin,
+// the minimum of runningMin's value upon entry and all values in [lo, i), or -1 if there's no such i.
+// Upon return, runningMin holds the minimum preceding the returned i (or of [lo, hi], when -1 is returned).
+// A subtree whose values are all positive and at most ratio times the smaller of runningMin and its minimum
+// can't contain such an i, and is skipped.  The comparisons are those made by findCutoff()'s linear scan.
+int MinMaxTree::firstTrendReversal(const int& lo, const int& hi, const long double& ratio, int& runningMin) const
+{
+  if (lo > hi)
+    return -1;
+  return firstTrendReversal(1, 0, m_numLeaves - 1, lo, hi, ratio, runningMin);
+}
+
+int MinMaxTree::firstTrendReversal(const int& node, const int& nodeL, const int& nodeR, const int& lo, const int& hi,
+                                   const long double& ratio, int& runningMin) const
+{
+  if (nodeR < lo || nodeL > hi)
+    return -1;
+  if (lo <= nodeL && nodeR <= hi)
+    {
+      const int mn = min(runningMin, m_min[node]);
+      if (m_min[node] > 0 && static_cast<long double>(m_max[node]) <= ratio * static_cast<long double>(mn))
+        {
+          runningMin = mn;
+          return -1;
+        }
+      if (nodeL == nodeR)
+        {
+          const int val = m_min[node];
+          if (static_cast<long double>(val) > ratio * static_cast<long double>(runningMin) || 0 == val)
+            return nodeL;
+          if (val < runningMin)
+            runningMin = val;
+          return -1;
+        }
+    }
+  const int mid = nodeL + (nodeR - nodeL) / 2;
+  const int idx = firstTrendReversal(2 * node, nodeL, mid, lo, hi, ratio, runningMin);
+  if (idx != -1)
+    return idx;
+  return firstTrendReversal(2 * node + 1, mid + 1, nodeR, lo, hi, ratio, runningMin);
+}
+
+// Returns the last i in [lo, hi] whose value is <= val, or -1 if there's no such i.
+int MinMaxTree::lastAtMost(const int& lo, const int& hi, const int& val) const
+{
+  if (lo > hi)
+    return -1;
+  return lastAtMost(1, 0, m_numLeaves - 1, lo, hi, val);
+}
+
+int MinMaxTree::lastAtMost(const int& node, const int& nodeL, const int& nodeR, const int& lo, const int& hi, const int& val) const
+{
+  if (nodeR < lo || nodeL > hi || m_min[node] > val)
+    return -1;
+  if (nodeL == nodeR)
+    return nodeL;
+  const int mid = nodeL + (nodeR - nodeL) / 2;
+  const int idx = lastAtMost(2 * node + 1, mid + 1, nodeR, lo, hi, val);
+  if (idx != -1)
+    return idx;
+  return lastAtMost(2 * node, nodeL, mid, lo, hi, val);
+}
+
+// The distribution of counts observed in the background window, and the null model's values for each count.
+// Each field has its own array, so that the loops over occurrence counts and their moving averages
+// (findCutoff(), the running sums) and those over pmfs and P-values (computeStats()) stream through densely packed values.
+// MAxN is mirrored in MAxNtree, so it must be modified via setMAxN() or, after modifying many values, syncMAxNtree().
+struct CountDistribution {
+  vector<int> numOccs; // number of occurrences
+  vector<int> MAxN; // moving average of number-of-occurrences, but not divided by N
+  vector<long double> pmf; // probability mass function
+  vector<long double> pval; // P-value, probability of observing a count this large or larger
+  MinMaxTree MAxNtree;
+  size_t size(void) const { return numOccs.size(); };
+  bool empty(void) const { return numOccs.empty(); };
+  void setMAxN(const int& k, const int& val) { MAxN[k] = val; MAxNtree.set(k, val); };
+  void syncMAxNtree(void) { MAxNtree.assign(MAxN); };
+  void push_back(const int& n, const long double& p = -1.);
+  void pop_back(void);
+  void clear(void);
+};
+
+// MAxN is left undefined (-1); moving averages aren't computed until/unless we're sliding, for efficiency's sake.
+inline void CountDistribution::push_back(const int& n, const long double& p)
+{
+  numOccs.push_back(n);
+  MAxN.push_back(-1);
+  MAxNtree.set(static_cast<int>(MAxN.size()) - 1, -1); // the leaf might hold a popped bin's value
+  pmf.push_back(p);
+  pval.push_back(-1.);
+}
+
+inline void CountDistribution::pop_back(void)
+{
+  numOccs.pop_back();
+  MAxN.pop_back();
+  pmf.pop_back();
+  pval.pop_back();
+}
+
+void CountDistribution::clear(void)
+{
+  numOccs.clear();
+  MAxN.clear();
+  pmf.clear();
+  pval.clear();
+}
+
+class BackgroundRegionManager {
+public:
+  BackgroundRegionManager(const NullModelSettings& nullModel);
+  ~BackgroundRegionManager(void);
+  void setBounds(const string* pChrom, const int posL, const int posR);
+  const int& getRightEdge(void) const { return m_posR; };
+  const bool& isSliding(void) const { return m_sliding; };
+  void add(const SiteRange& s);
+  void computePandFlush(SiteManager& sm);
+  void slideAndCompute(const SiteRange& s, SiteManager& sm);
+  void slideRun(const SiteRange& run, SiteManager& sm);
+#ifdef HOTSPOT2_MICROBENCH
+  // For hotspot2_microbench, which times findCutoff() and tailSum() in isolation; not compiled into the other programs.
+  void benchFitNullModel(void);
+  void benchFindCutoff(const bool& sliding);
+  long double benchTailSum(const int& k) { return tailSum(k); };
+  const int& benchCutoff(void) const { return m_kcutoff; };
+  bool benchIsNegativeBinomial(void) const { return &nextProbNegativeBinomial == m_pmf; };
+  const vector<long double>& benchPmfParams(void) const { return m_pmfParams; };
+#endif
+
+private:
+  bool assignPvalueToCentralSite(SiteManager& sm, bool& needToComputePMFs, const long& numSlides);
+  BackgroundRegionManager(void); // require use of the constructor with 1 argument
+  BackgroundRegionManager(const BackgroundRegionManager&); // ditto
+  void reset(void);
+  void rebuildFrom(BackgroundRegionManager& brm);
+  void verify(const int& k, const long double& pval);
+  void findCutoff(const RunStats::CutoffTrigger& trigger);
+  void computeStats(const int& this_k, const RunStats::FitTrigger& trigger);
+  long double getPvalue(const unsigned int& k);
+  long double tailSum(const int& k);
+  bool atPvalueFloor(const int& k, const long double& pmf, long double& pval);
+  long double closedFormPvalue(const unsigned int& k);
+  void appendBin(const int& k, const long double& pmf);
+  void setPmfCoefficients(const long double& prob0);
+  bool computePvaluesDouble(const int& kFirstNewPmf, int& kLast, const int& kLowestPval);
+  void copyPvaluesDouble(const int& kFirstNewPmf, const int& kLast, const int& kLowestPval, const bool& toDistn);
+  int m_posL;
+  int m_posR;
+  int m_posC;
+  long m_runningSum_count;
+  long m_runningSum_countSquared;
+  int m_numPtsInNullRegion;
+  long m_runningSum_count_duringPrevComputation;
+  long m_runningSum_countSquared_duringPrevComputation;
+  int m_numPtsInNullRegion_duringPrevComputation;
+
+  int m_MAlength;
+  long double m_thresholdRatio;
+  CountDistribution m_distn; // distribution of observed counts
+  BackgroundSites m_sitesInRegion; // endPos values of the sites in the region and whether P has been assigned
+  int m_modeXval;
+  int m_modeYval;
+  int m_kcutoff;
+  int m_kTrendReversal;
+  bool m_sliding;
+  bool m_needToUpdate_kcutoff;
+  bool m_warningAlreadyIssued; // see computeStats()
+  int m_minMAxN;
+  int m_prev_k;
+  long double m_minPvalue; // see atPvalueFloor()
+  int m_kFloorSearchStart;
+  int m_kFloor; // lowest k whose P-value is at most m_minPvalue, if the pmfs have been computed that far; -1 otherwise
+
+  int m_samplingInterval;
+  int m_nextPosToSample;
+  int m_sampledDataDistnSize;
+
+  long double (*m_pmf)(const int&, const long double&, const vector<long double>&); // Make these member variables, not local variables,
+  vector<long double> m_pmfParams; // so they can be accessed outside computeStats() for debugging.
+  const string* m_pCurChrom;
+
+  bool m_doubleKernels; // see computePvaluesDouble()
+  PmfCoefficients m_pmfCoeffs;
+  double m_prob0D;
+  vector<double> m_pmfD; // indexed like m_distn
+  vector<long double> m_pvalD; // ditto; long double only so that it can also hold the long double fallback values
+  PrecisionCheck m_precisionCheck; // used if m_pPrecisionCheckTotal != NULL
+  PrecisionCheck* m_pPrecisionCheckTotal; // receives m_precisionCheck upon destruction
+
+  bool m_closedFormTails; // see closedFormPvalue()
+  unsigned long m_fitNumber; // incremented for each new fit
+  vector<long double> m_closedFormPvals; // P-values by k, valid where m_closedFormPvalFits[k] == m_fitNumber
+  vector<unsigned long> m_closedFormPvalFits;
+
+  NullModelCache* m_pTableCache; // NULL if the cache is disabled
+  NullModelTable* m_pCurTable; // the current fit's entry in m_pTableCache, if any
+  NullModelCacheStats* m_pTableCacheStatsTotal; // receives m_pTableCache's counts upon destruction
+
+  RunStats m_runStats; // counts only; times are kept by SiteFeeder
+  RunStats* m_pRunStatsTotal; // receives m_runStats upon destruction
+
+  int m_verifyInterval; // see verify()
+  int m_numSlidesSinceVerify;
+  BackgroundRegionManager* m_pReference; // recomputes the statistics from scratch; NULL unless m_verifyInterval > 0
+};
+
+BackgroundRegionManager::BackgroundRegionManager(const NullModelSettings& nullModel)
+{
+  m_posL = m_posC = m_posR = -1;
+  m_runningSum_count = m_runningSum_countSquared
+    = m_runningSum_count_duringPrevComputation = m_runningSum_countSquared_duringPrevComputation = 0;
+  m_numPtsInNullRegion = m_numPtsInNullRegion_duringPrevComputation = 0;
+  m_kcutoff = m_modeYval = m_modeXval = -1;
+  m_MAlength = nullModel.MAlength; // see explanation in findCutoff(); 5 is good when samplingInterval = 1, 15 is good when windowSize/samplingInterval ~= 250
+  m_thresholdRatio = 1.33; // see explanation in findCutoff(); could instead try 1.4. 1.5 seems to be too high, 1.2 seems to be too low.
+  m_sliding = false;
+  m_needToUpdate_kcutoff = true;
+  m_warningAlreadyIssued = false;
+
+  m_samplingInterval = nullModel.samplingInterval;
+  m_nextPosToSample = -1;
+  m_sampledDataDistnSize = 0;
+
+  m_minMAxN = m_kTrendReversal = -1;
+  m_prev_k = -1;
+  m_minPvalue = nullModel.minPvalue;
+  m_kFloorSearchStart = 1;
+  m_kFloor = -1;
+  m_pmf = NULL;
+  m_pCurChrom = NULL;
+
+  m_doubleKernels = nullModel.doubleKernels;
+  m_pmfCoeffs.A = m_pmfCoeffs.B = 0.;
+  m_pmfCoeffs.kMax = 0;
+  m_prob0D = 1.;
+  m_pPrecisionCheckTotal = nullModel.pPrecisionCheck;
+
+  m_closedFormTails = nullModel.closedFormTails;
+  m_fitNumber = 1;
+
+  m_pTableCache = nullModel.tableCacheSize > 0 ? new NullModelCache(nullModel.tableCacheSize) : NULL;
+  m_pCurTable = NULL;
+  m_pTableCacheStatsTotal = nullModel.pTableCacheStats;
+
+  m_pRunStatsTotal = nullModel.pRunStats;
+
+  m_verifyInterval = nullModel.verifyInterval;
+  m_numSlidesSinceVerify = 0;
+  m_pReference = NULL;
+  if (m_verifyInterval > 0)
+    {
+      // Same null model, but nothing cached, checked or tallied, so that it only does the recomputation.
+      NullModelSettings referenceModel(nullModel);
+      referenceModel.pPrecisionCheck = NULL;
+      referenceModel.tableCacheSize = 0;
+      referenceModel.pTableCacheStats = NULL;
+      referenceModel.pRunStats = NULL;
+      referenceModel.verifyInterval = 0;
+      m_pReference = new BackgroundRegionManager(referenceModel);
+    }
+}
+
+BackgroundRegionManager::~BackgroundRegionManager(void)
+{
+  delete m_pReference;
+  if (m_pPrecisionCheckTotal)
+    m_pPrecisionCheckTotal->merge(m_precisionCheck);
+  if (m_pTableCache)
+    {
+      if (m_pTableCacheStatsTotal)
+        m_pTableCacheStatsTotal->merge(m_pTableCache->getStats());
+      delete m_pTableCache;
+    }
+  if (m_pRunStatsTotal)
+    m_pRunStatsTotal->merge(m_runStats);
+}
+
+void BackgroundRegionManager::setBounds(const string* pChrom, const int posL, const int posR)
+{
+  if (posR <= posL)
+    {
+      cerr << "Error:  BackgroundRegionManager::setBounds() received posL = "
+           << posL << " and posR = " << posR << "; must have posL <= posR."
+           << endl
+           << endl;
+      exit(1);
+    }
+  m_pCurChrom = pChrom; // used solely for warning and error messages and debugging
+  m_posL = posL;
+  m_posR = posR;
+  m_posC = m_posL + (m_posR - m_posL) / 2; // integer division
+  m_nextPosToSample = m_posL;
+  m_sitesInRegion.reserve(m_posR - m_posL + 1);
+}
+
+void BackgroundRegionManager::add(const SiteRange& s)
+{
+  if (s.endPos > m_posR)
+    {
+      cerr << "Coding error:  BRM::add(), region " << *m_pCurChrom << ':' << m_posL << '-' << m_posR
+           << " received out-of-bounds position " << s.endPos
+           << " (line " << __LINE__ << " of the code)." << endl
+           << endl;
+      exit(1);
+    }
+  SiteData sd;
+  sd.pos = s.endPos;
+  sd.count = s.count;
+  sd.hasPval = false;
+  sd.sampled = false;
+
+  if (1 != m_samplingInterval && s.endPos > m_nextPosToSample)
+    m_nextPosToSample = s.endPos;
+
+  // Alternatively, "sampling" could be performed strictly at multiples of m_samplingInterval.
+  // If we intend to sample at, say, positions 200, 400, 600, 800, 1000, etc.,
+  // and regions 390-402 and 598-620 are excluded (unmappable),
+  // then the current code will sample at 200, 403, 621, 821, etc.
+  // Sampling strictly at multiples of m_samplingInterval would in this case
+  // sample at 200, 800, 1000, etc.
+  // Use the following code if strict multiples of m_samplingInterval are desired.
+  //
+  // m_nextPosToSample += static_cast<int>(ceil(static_cast<double>(s.endPos - m_nextPosToSample)/static_cast<double>(m_samplingInterval))) * m_samplingInterval;
+  //
+  // The above is a one-step version of "while(s.endPos > m_nextPosToSample){m_nextPosToSample += m_samplingInterval;}."
+  // Typically, m_nextPosToSample will only need to increase by m_samplingInterval;
+  // it will need to increase by a greater multiple of m_samplingInterval when a large gap is present in the data
+  // (an unmappable region or otherwise restricted/withheld region).
+
+  if (1 == m_samplingInterval || s.endPos == m_nextPosToSample)
+    {
+      sd.sampled = true;
+      m_nextPosToSample += m_samplingInterval;
+      // Add the incoming site's count to the distribution of counts observed in this region.
+      if (s.count < static_cast<int>(m_distn.size()))
+        m_distn.numOccs[s.count]++;
+      else
+        {
+          while (static_cast<int>(m_distn.size()) < s.count)
+            {
+              m_distn.push_back(0); // create bins for unobserved interior values, e.g., count = 5 but only 0,1,2 have been observed so far
+              m_sampledDataDistnSize++;
+            }
+          m_distn.push_back(1);
+          m_sampledDataDistnSize++;
+          m_runStats.noteDistnSize(m_distn.size());
+        }
+      if ( static_cast<int>(m_distn.size()) >= m_MAlength && m_distn.MAxN[s.count] != -1 && m_distn.MAxN[s.count] >= m_modeYval)
+        {
+          m_modeXval = s.count;
+          m_modeYval = m_distn.MAxN[s.count];
+        }
+    }
+
+  // Add the incoming site to the appropriate half of the window's observed positions.
+  if (s.endPos < m_posC)
+    m_sitesInRegion.pushLeft(sd);
+  else
+    m_sitesInRegion.pushRight(sd);
+}
+
+#ifdef HOTSPOT2_MICROBENCH
+// Fit the null model to the sites add()ed so far, as at the start of a background window.
+void BackgroundRegionManager::benchFitNullModel(void)
+{
+  benchFindCutoff(false);
+  computeStats(-1, RunStats::FIT_AT_WINDOW_START);
+}
+
+// With sliding == false, the moving averages are recomputed first, as at the start of a window;
+// with sliding == true, only the search for the trend reversal is done, as while the window slides.
+void BackgroundRegionManager::benchFindCutoff(const bool& sliding)
+{
+  m_sliding = sliding;
+  findCutoff(sliding ? RunStats::CUTOFF_ON_SLIDE : RunStats::CUTOFF_AT_WINDOW_START);
+}
+#endif // HOTSPOT2_MICROBENCH
+
+void BackgroundRegionManager::findCutoff(const RunStats::CutoffTrigger& trigger)
+{
+  // In all three noise models employed (negative binomial (NB), binomial, and Poisson,
+  // though the NB is essentially always used because the data essentially always has variance > mean),
+  // the distribution monotonically decreases beyond its mode.
+  // Our idea is to identify a cutoff, when one exists,
+  // which essentially marks the upper bound of observed monotonic decrease.
+  // (Observations beyond the cutoff are then "predominantly signal," rather than noise.)
+  // We do this by starting just beyond the mode of the
+  // moving averages (MAs) of occurrence counts.
+  // Whenever we encounter a global minimum (among values seen so far) in the MAs,
+  // we measure whether a subsequent MA is substantially greater,
+  // i.e. above some threshold (e.g., an increase of 33.3% or more).
+  // If such an extreme increase is observed,
+  // then we declare that "global minimum so far" to be the cutoff value.
+  // If we exhaust the set of observations and no such increase is detected,
+  // the highest observation is returned, i.e., no points are actually "cut off."
+  // If a new "global minimum so far" is observed, below the previous "global minimum so far,"
+  // the previous global minimum is ignored and the search process begins anew at the new local minimum.
+  //
+  // If no "trend reversal" is detected, but we detect a contiguous set of empty histogram bins,
+  // we set the cutoff at the value immediately preceding those empty histogram bins.
+
+  int kcutoff_uponEntry = m_kcutoff;
+  m_runStats.numFindCutoffCalls[trigger]++;
+
+  if (m_sampledDataDistnSize < m_MAlength)
+    {
+      // Too few distinct count values were observed to compute a moving average of length MAlength;
+      // set the "cutoff" to the largest observed count, i.e., use all data, don't "cut off" any points.
+      m_kcutoff = m_sampledDataDistnSize - 1;
+      m_minMAxN = m_kTrendReversal = -1;
+      m_modeXval = m_modeYval = -1;
+      m_needToUpdate_kcutoff = false;
+
+      if (m_kcutoff != kcutoff_uponEntry)
+        {
+        UpdateNullRegionStatsAndExit:
+          // The boundary of the null region has changed.
+          // Recompute the running sums and the number of observations in the null region.
+          if (kcutoff_uponEntry <= 0)
+            {
+              // Compute from scratch.
+              m_runningSum_count = m_runningSum_countSquared = 0;
+              m_numPtsInNullRegion = 0;
+              for (long kk = 0; kk <= static_cast<long>(m_kcutoff); kk++)
+                {
+                  m_runningSum_count += static_cast<long>(m_distn.numOccs[kk]) * kk;
+                  m_runningSum_countSquared += static_cast<long>(m_distn.numOccs[kk]) * kk * kk;
+                  m_numPtsInNullRegion += m_distn.numOccs[kk];
+                }
+            }
+          else
+            {
+              if (m_kcutoff > kcutoff_uponEntry)
+                {
+                  // The null region has expanded; increase the values accordingly.
+                  for (long kk = static_cast<long>(kcutoff_uponEntry + 1);
+		       kk <= static_cast<long>(m_kcutoff); kk++)
+                    {
+                      m_runningSum_count += static_cast<long>(m_distn.numOccs[kk]) * kk;
+                      m_runningSum_countSquared += static_cast<long>(m_distn.numOccs[kk]) * kk * kk;
+                      m_numPtsInNullRegion += m_distn.numOccs[kk];
+                    }
+                }
+              else
+                {
+                  // The null region has contracted; decrease the values accordingly.
+                  for (long kk = static_cast<long>(kcutoff_uponEntry); kk > static_cast<long>(m_kcutoff); kk--)
+                    {
+                      m_runningSum_count -= static_cast<long>(m_distn.numOccs[kk]) * kk;
+                      m_runningSum_countSquared -= static_cast<long>(m_distn.numOccs[kk]) * kk * kk;
+                      m_numPtsInNullRegion -= m_distn.numOccs[kk];
+                    }
+                }
+            }
+        }
+
+      return;
+    }
+
+  int sum(0), idxL(m_modeXval + 1), idxR(m_modeXval + 1 + m_MAlength - 1); // these idxL and idxR values will be ignored/replaced if !m_sliding
+  int idxC = m_modeXval + 1 + m_MAlength / 2; // integer division; see commendt directly above re: idxL and idxR
+  pair<int, int> xyCurMAxN;
+  bool useGlobMin(false);
+
+  if (!m_sliding)
+    {
+      // Need to compute the moving averages (MAs).
+      // Technically, these aren't moving averages, they're sums,
+      // because we're not dividing sums by the number of terms.
+      // But these "MA x N" values function as MAs.
+      // Benefits:  No unnecessary division and casting from int to double,
+      // and we gain the ability to perform exact tests for equality
+      // (int == int instead of double == double).
+      idxL = 0;
+      idxC = idxL + m_MAlength / 2;
+      idxR = idxL + m_MAlength - 1;
+      // Compute the initial moving average (times the number of terms).
+      for (int i = idxL; i <= idxR; i++)
+        sum += m_distn.numOccs[i];
+      m_distn.MAxN[idxC] = sum;
+      if (-1 == m_modeYval || m_distn.MAxN[idxC] > m_modeYval)
+        {
+          m_modeXval = idxC;
+          m_modeYval = m_distn.MAxN[idxC];
+        }
+      while (idxR < m_sampledDataDistnSize - 1)
+        {
+          idxC++;
+          idxR++;
+          sum -= m_distn.numOccs[idxL];
+          sum += m_distn.numOccs[idxR];
+          m_distn.MAxN[idxC] = sum;
+          if (m_distn.MAxN[idxC] > m_modeYval)
+            {
+              m_modeXval = idxC;
+              m_modeYval = m_distn.MAxN[idxC];
+            }
+          idxL++;
+        }
+      m_distn.syncMAxNtree();
+      if (idxL > m_modeXval + 1)
+        {
+          idxL = m_modeXval + 1;
+          idxC = idxL + m_MAlength / 2;
+          idxR = idxL + m_MAlength - 1;
+        }
+      // else the "while" loop below won't get executed
+    }
+  // Scan the moving averages to the right of idxC for the first one that's either 0
+  // or at least m_thresholdRatio times the "global minimum so far," which starts at idxC.
+  // The tree finds it without visiting the stretches that contain neither.
+  int kMin(-1), kLast(idxC + (m_sampledDataDistnSize - 1 - idxR));
+  if (idxR != m_sampledDataDistnSize - 1)
+    {
+      m_minMAxN = m_distn.MAxN[idxC];
+      xyCurMAxN.first = m_distn.MAxNtree.firstTrendReversal(idxC + 1, kLast, m_thresholdRatio, m_minMAxN);
+      if (xyCurMAxN.first != -1)
+        {
+          useGlobMin = true;
+          xyCurMAxN.second = m_distn.MAxN[xyCurMAxN.first];
+          if (static_cast<long double>(xyCurMAxN.second) > m_thresholdRatio * static_cast<long double>(m_minMAxN))
+            {
+              // If there are ties (multiple k values with the same MAxN values), use the highest of these k values.
+              kMin = m_distn.MAxNtree.lastAtMost(idxC, xyCurMAxN.first - 1, m_minMAxN);
+            }
+          else
+            {
+              // We've detected a contiguous stretch of at least m_MAlength empty histogram bins.
+              // Set the global minimum here.
+              kMin = xyCurMAxN.first;
+              m_minMAxN = 0;
+            }
+        }
+    }
+
+  // If useGlobMin is false, then we exhausted all observed values
+  // without finding an "extreme" global minimum in the moving averages.
+  // Return the maximum observed count as the "cutoff."
+  if (!useGlobMin)
+    {
+      m_kcutoff = m_sampledDataDistnSize - 1;
+      m_kTrendReversal = -1;
+      m_minMAxN = -1;
+      m_needToUpdate_kcutoff = false;
+      if (m_kcutoff != kcutoff_uponEntry)
+        goto UpdateNullRegionStatsAndExit;
+      return;
+    }
+  // Otherwise, return the "global minimum so far" as the cutoff.
+  m_kcutoff = kMin;
+
+  if (m_minMAxN > 0)
+    m_kTrendReversal = xyCurMAxN.first; // where we determined the monotonically decreasing trend to have reversed
+  else
+    m_kTrendReversal = -1;
+
+  m_needToUpdate_kcutoff = false;
+  if (m_kcutoff != kcutoff_uponEntry)
+    goto UpdateNullRegionStatsAndExit;
+}
+
+void BackgroundRegionManager::computeStats(const int& this_k, const RunStats::FitTrigger& trigger)
+{
+  m_runStats.numComputeStatsCalls[trigger]++;
+  if (-1 != this_k && -1 != m_prev_k && -1 != m_kFloor)
+    return; // the pmfs already extend to the P-value floor, and larger counts get the floor (see getPvalue())
+  m_kFloor = -1;
+  const bool newFit(-1 == this_k || -1 == m_prev_k); // otherwise, we're extending the current fit's pmfs
+  if (newFit)
+    {
+      m_pCurTable = NULL;
+      m_fitNumber++;
+    }
+  else if (m_closedFormTails)
+    return; // there are no pmfs to extend
+
+  if (1 == m_sampledDataDistnSize)
+    {
+      // All observations within this region were of count == 0.
+      m_distn.pmf[0] = m_distn.pval[0] = 1.;
+      m_runningSum_count_duringPrevComputation = m_runningSum_count;
+      m_runningSum_countSquared_duringPrevComputation = m_runningSum_countSquared;
+      m_numPtsInNullRegion = m_distn.numOccs[0];
+      m_numPtsInNullRegion_duringPrevComputation = m_numPtsInNullRegion;
+      m_prev_k = 0;
+      m_pmf = &nextProbPoisson;
+      m_pmfParams.clear();
+      m_pmfParams.push_back(0.);
+      m_kFloorSearchStart = 1;
+      if (m_doubleKernels || m_pPrecisionCheckTotal)
+        {
+          int kLast(0);
+          setPmfCoefficients(1.);
+          computePvaluesDouble(0, kLast, 0);
+        }
+      return;
+    }
+
+  int k;
+  // Make *pmf() and params private member variables,
+  // so they can be accessed elsewhere during debugging.
+  long double prob0; // probability of observing 0 counts by random chance
+  long double m; // mean
+  long double v; // variance
+  long double N(static_cast<long double>(m_numPtsInNullRegion));
+  m = static_cast<long double>(m_runningSum_count) / N;
+  v = (static_cast<long double>(m_runningSum_countSquared) - N * m * m) / (N - 1.);
+  m_pmfParams.clear();
+
+  // Set up the negative binomial model.
+  // Double-check that m < v; if m >= v, which is extremely unlikely,
+  // use a more appropriate model (binomial or Poisson).
+  // Use the definitions of variance and mean to perform an integer (exact) test for m == v.
+  if (m_numPtsInNullRegion * m_runningSum_countSquared - m_runningSum_count*m_runningSum_count == m_runningSum_count*(m_numPtsInNullRegion - 1))
+    {
+      // Poisson, m = v
+      m_pmfParams.push_back(m);
+      m_pmf = &nextProbPoisson;
+      if ((0 == m_runningSum_count || 1 == m_runningSum_count) && !m_warningAlreadyIssued)
+        {
+          cerr << "Warning:  In region " << *m_pCurChrom << ':' << m_posL << '-' << m_posR
+               << ", all counts used for statistics were 0, or all were 0 except one was 1.\n"
+               << "This generally should not happen.  If this region is unmappable or problematic for other reasons,\n"
+               << "it would almost certainly be best to filter it out of the input.\n"
+               << "There may be other such regions in the input; this warning will only be issued once during this run\n"
+               << "(once per input segment when multiple threads are used)."
+               << endl;
+          m_warningAlreadyIssued = true;
+        }
+    }
+  else
+    {
+      if (m < v)
+        {
+          // negative binomial
+          long double r = m * m / (v - m);
+          m_pmfParams.push_back(m);
+          m_pmfParams.push_back(r);
+          m_pmf = &nextProbNegativeBinomial;
+        }
+      else // m > v (this is very unlikely)
+        {
+          // binomial
+          long double n(floor(m * m / (m - v) + 0.5)); // estimate n of the fit from the observed mean and variance
+          long double kk_max(static_cast<long double>(m_kcutoff)); // BUGBUG if m_kcutoff has 0 observations, do we still want to use it here??!?
+          if (kk_max > n + 0.1) // + 0.1 to account for roundoff error, e.g. k=16.00001 and n=15.99999
+            {
+              // We don't expect this to happen, but if the estimated n is smaller than the observed m_kcutoff,
+              // then we need to set n = m_kcutoff to allow m_kcutoff to be generated by the binomial model.
+              n = kk_max;
+            }
+          // Now that we've set n, there's inconsistency among n, m, and v, with respect to the binomial.
+          // We choose to keep m as observed, and update the variance parameter v so that consistency is achieved.
+          v = m * (1. - m / n); // Now m*m/(m-v) = the integer n. Example: m=1.8952, v=1.6747, n=16.2893-->16, v-->1.6701.
+          m_pmfParams.push_back(m);
+          m_pmfParams.push_back(v);
+          m_pmfParams.push_back(n);
+          if (v > 1.0e-8)
+            m_pmf = &nextProbBinomial;
+          else
+            {
+              m_pmf = NULL;
+              return;
+            }
+        }
+    }
+
+  if (m_closedFormTails)
+    {
+      // P-values get computed by getPvalue() as they're needed.
+      m_prev_k = (-1 != this_k) ? this_k : m_sampledDataDistnSize - 1;
+      m_runningSum_count_duringPrevComputation = m_runningSum_count;
+      m_runningSum_countSquared_duringPrevComputation = m_runningSum_countSquared;
+      m_numPtsInNullRegion_duringPrevComputation = m_numPtsInNullRegion;
+      return;
+    }
+
+  // Now compute the minimum necessary number of pmf values, from the null model (e.g. negative binomial fit).
+  // If the user has specified a P-value floor (--min-pvalue), no pmf values are computed beyond the count
+  // whose P-value reaches it, and the P-values reported for larger counts asymptote at the floor.
+  // If a P-value is, say, 1.23456e-218, we rarely need to know that,
+  // rather than that it's something smaller than, say, 1e-100.
+  m_kFloorSearchStart = static_cast<int>(m) + 1;
+
+  // If this fit's pmfs are in the cache, take them from there (through k_end at most) rather than recomputing them.
+  if (newFit && m_pTableCache)
+    {
+      NullModelKey key;
+      key.sum = m_runningSum_count;
+      key.sumSq = m_runningSum_countSquared;
+      key.N = m_numPtsInNullRegion;
+      key.kcutoff = (&nextProbBinomial == m_pmf) ? m_kcutoff : -1;
+      if (!(m_pCurTable = m_pTableCache->find(key)))
+        m_pCurTable = m_pTableCache->insert(key);
+    }
+  if (!newFit)
+    prob0 = m_distn.pmf[0]; // not used
+  else if (m_pCurTable && !m_pCurTable->pmf.empty())
+    prob0 = m_pCurTable->pmf[0];
+  else if (&nextProbPoisson == m_pmf) // m_pmfParams = m
+    prob0 = exp(-m_pmfParams[0]);
+  else if (&nextProbNegativeBinomial == m_pmf) // m, r
+    prob0 = pow(m_pmfParams[1] / (m_pmfParams[1] + m_pmfParams[0]), m_pmfParams[1]);
+  else // binomial; m, v, n
+    prob0 = pow(m_pmfParams[1] / m_pmfParams[0], m_pmfParams[2]);
+
+  long double curPMF(prob0);
+  int k_begin(1), k_end(m_sampledDataDistnSize - 1); // default (-1 == this_k):  compute for all k observed in the background window
+  int kFirstNewPmf(0);
+  if (-1 == this_k)
+    m_distn.pmf[0] = curPMF;
+  else
+    {
+      k_end = this_k;
+      if (-1 == m_prev_k) // compute for 0 <= k <= this_k.
+        m_distn.pmf[0] = curPMF;
+      else // compute for (highest k previously handled) < k <= this_k.
+        {
+          curPMF = m_distn.pmf[m_prev_k];
+          k_begin = kFirstNewPmf = m_prev_k + 1;
+        }
+    }
+
+  long double pvalAtFloor(-1.);
+  if (newFit && m_pCurTable && m_pCurTable->pmf.size() > 1)
+    {
+      const NullModelTable& t(*m_pCurTable);
+      int kCached(min(static_cast<int>(t.pmf.size()) - 1, k_end));
+      if (-1 != t.kFloor && t.kFloor <= k_end)
+        {
+          kCached = k_end = m_kFloor = t.kFloor;
+          pvalAtFloor = t.pvalAtFloor;
+        }
+      for (k = static_cast<int>(m_distn.size()); k <= kCached; k++)
+        appendBin(k, -1.);
+      for (k = 1; k <= kCached; k++)
+        m_distn.pmf[k] = t.pmf[k];
+      curPMF = m_distn.pmf[kCached];
+      k_begin = kFirstNewPmf = kCached + 1;
+    }
+
+  bool doublesComputed(false);
+  int kLast(max(k_end, k_begin - 1));
+  if (m_doubleKernels || m_pPrecisionCheckTotal)
+    {
+      for (k = static_cast<int>(m_distn.size()); k <= k_end; k++)
+        appendBin(k, -1.);
+      setPmfCoefficients(prob0);
+      doublesComputed = computePvaluesDouble(kFirstNewPmf, kLast, 0);
+      if (doublesComputed && m_doubleKernels)
+        {
+          copyPvaluesDouble(kFirstNewPmf, kLast, 0, true);
+          goto UpdatePrevComputationAndExit;
+        }
+    }
+
+  for (k = k_begin; k <= k_end; k++)
+    {
+      curPMF = m_pmf(k, curPMF, m_pmfParams); // note:  if pmf == binomial and k > binomial's n, 0 is returned
+      m_runStats.numPmfTerms++;
+      if (static_cast<int>(m_distn.size()) == k)
+        appendBin(k, curPMF);
+      m_distn.pmf[k] = curPMF;
+      if (atPvalueFloor(k, curPMF, pvalAtFloor))
+        {
+          m_kFloor = kLast = k++;
+          break;
+        }
+    }
+
+  // Because pmf(k) happens to be a multiple of pmf(k-1) for every k for each model (negative binomial, binomial, Poisson),
+  // we can write the P-value for observing k counts as
+  //
+  // pval(k) = pmf(k) * (1 + term(k+1) + term(k+2) + term(k+3) + ...),
+  //
+  // where the terms in the sum decrease monotonically with k.
+  // We can cap the sum at, say, 5 significant digits for pval(k),
+  // and then work backwards, filling in pval(k-1) = pmf(k-1) + pval(k),
+  // ending with pval(0) = 1.
+  // (See tailSum().)
+  {
+    k--; // reset so that k corresponds to the last pmf computed
+    m_distn.pval[k] = (m_kFloor == k) ? pvalAtFloor : m_distn.pmf[k] * tailSum(k);
+    //  if (m_distn.pval[k] < numeric_limits<double>::min())
+    //    m_distn.pval[k] = numeric_limits<double>::min();
+    while (k > 1)
+      {
+        m_distn.pval[k - 1] = m_distn.pmf[k - 1] + m_distn.pval[k];
+        //      if (m_distn.pval[k] < numeric_limits<double>::min())
+        //	m_distn.pval[k] = numeric_limits<double>::min();
+        k--;
+      }
+    m_distn.pval[0] = 1.; // explicitly set it to 1, to avoid potential round-off error
+  }
+  if (m_pPrecisionCheckTotal && !doublesComputed)
+    copyPvaluesDouble(kFirstNewPmf, kLast, 0, false); // --double-precision falls back to these too
+
+ UpdatePrevComputationAndExit:
+  if (-1 != m_kFloor)
+    m_prev_k = m_kFloor;
+  else if (-1 != this_k)
+    m_prev_k = this_k;
+  else
+    m_prev_k = m_sampledDataDistnSize - 1;
+
+  if (m_pCurTable) // add the newly computed pmfs to the cached table
+    {
+      NullModelTable& t(*m_pCurTable);
+      for (k = static_cast<int>(t.pmf.size()); k <= m_prev_k; k++)
+        t.pmf.push_back(m_distn.pmf[k]);
+      if (-1 != m_kFloor)
+        {
+          t.kFloor = m_kFloor;
+          t.pvalAtFloor = m_distn.pval[m_kFloor];
+        }
+    }
+
+  m_runningSum_count_duringPrevComputation = m_runningSum_count;
+  m_runningSum_countSquared_duringPrevComputation = m_runningSum_countSquared;
+  m_numPtsInNullRegion_duringPrevComputation = m_numPtsInNullRegion;
+}
+
+long double BackgroundRegionManager::getPvalue(const unsigned int& k)
+{
+  if (m_closedFormTails)
+    return closedFormPvalue(k);
+  if (-1 != m_kFloor && static_cast<int>(k) >= m_kFloor)
+    return m_minPvalue; // see atPvalueFloor()
+  if (k < m_distn.size()) // Yes, m_distn.size(), not m_sampledDataDistnSize
+    {
+      if (m_pPrecisionCheckTotal && k < m_pvalD.size())
+        m_precisionCheck.compare(m_distn.pval[k], m_pvalD[k]);
+      return m_distn.pval[k];
+    }
+
+  // k is greater than all count values in the distribution, so we need to add bin(s) for it.
+  // This can only happen if the user has specified a sampling interval
+  // and k happens to have not been sampled.
+
+  if (NULL == m_pmf || m_pmfParams.empty())
+    {
+      cerr << "Coding error:  BRM::getPvalue(" << k << ") was called when m_pmf == NULL and/or m_pmfParams.empty() == true." << endl;
+      exit(1);
+    }
+
+  const int prev_max_k(static_cast<int>(m_distn.size()) - 1); // Yes, m_distn.size(), not m_sampledDataDistnSize.
+  m_runStats.numDistnExtensions++;
+  m_runStats.numBinsFromExtensions += static_cast<long>(k) - prev_max_k;
+  bool doublesComputed(false);
+  if (m_doubleKernels || m_pPrecisionCheckTotal)
+    {
+      int kLast(k);
+      for (int kk = prev_max_k + 1; kk <= static_cast<int>(k); kk++)
+        appendBin(kk, -1.);
+      doublesComputed = computePvaluesDouble(prev_max_k + 1, kLast, prev_max_k + 1);
+      if (doublesComputed && m_doubleKernels)
+        {
+          copyPvaluesDouble(prev_max_k + 1, kLast, prev_max_k + 1, true);
+          return -1 != m_kFloor ? m_minPvalue : m_distn.pval[k];
+        }
+    }
+
+  int kk = prev_max_k;
+  long double curPMF(m_distn.pmf[kk]), pvalAtFloor(-1.);
+  while (kk < static_cast<int>(k)) // We're growing the vector until k fits into its highest bin.
+    {
+      curPMF = m_pmf(++kk, curPMF, m_pmfParams);
+      m_runStats.numPmfTerms++;
+      if (static_cast<int>(m_distn.size()) == kk)
+        appendBin(kk, curPMF);
+      m_distn.pmf[kk] = curPMF;
+      if (atPvalueFloor(kk, curPMF, pvalAtFloor))
+        {
+          m_kFloor = kk;
+          break;
+        }
+    }
+  // Compute the P-value.  See comments in method computeStats() for further info.
+  // kk == k at this point, unless the P-value floor was reached first.
+  const int kTop(kk);
+  m_distn.pval[kTop] = (m_kFloor == kTop) ? pvalAtFloor : m_distn.pmf[kTop] * tailSum(kTop);
+  //  if (m_distn.pval[k] < numeric_limits<double>::min())
+  //    m_distn.pval[k] = numeric_limits<double>::min();
+  // Fill in P-values for any bins that were added between prev_max_k and k.
+  while (kk > prev_max_k + 1)
+    {
+      m_distn.pval[kk - 1] = m_distn.pmf[kk - 1] + m_distn.pval[kk];
+      //      if (m_distn.pval[k] < numeric_limits<double>::min())
+      //	m_distn.pval[k] = numeric_limits<double>::min();
+      kk--;
+    }
+
+  if (-1 != m_kFloor)
+    return m_minPvalue;
+  if (m_pPrecisionCheckTotal)
+    {
+      if (!doublesComputed)
+        copyPvaluesDouble(prev_max_k + 1, k, prev_max_k + 1, false);
+      m_precisionCheck.compare(m_distn.pval[k], m_pvalD[k]);
+    }
+  return m_distn.pval[k];
+}
+
+// Returns pval(k)/pmf(k), i.e., 1 + term(k+1) + term(k+2) + ..., with the terms relative to pmf(k);
+// see computeStats().
+long double BackgroundRegionManager::tailSum(const int& k)
+{
+  int j = k;
+  long double sum(1.), prevTerm(1.), curTerm;
+  const long double SMALL_VALUE(5.0e-7); // restrict the correctness of the final P-value to ~5 significant digits
+  while ((curTerm = m_pmf(++j, prevTerm, m_pmfParams)) > SMALL_VALUE)
+    {
+      sum += curTerm;
+      prevTerm = curTerm;
+    }
+  m_runStats.numTailSumTerms += j - k;
+  return sum;
+}
+
+// Returns true, and puts the P-value for k into pval, if the P-value reaches the floor set with --min-pvalue.
+// Callers check k in increasing order, so the first k for which this returns true is m_kFloor.
+// Because pval(k) >= pmf(k), the tail only needs to be summed once pmf(k) is at or below the floor;
+// counts at or below the mean are skipped, so the left tail of the distribution never gets summed.
+bool BackgroundRegionManager::atPvalueFloor(const int& k, const long double& pmf, long double& pval)
+{
+  if (m_minPvalue <= 0 || k < m_kFloorSearchStart || pmf > m_minPvalue)
+    return false;
+  pval = pmf * tailSum(k);
+  return pval <= m_minPvalue;
+}
+
+// With --closed-form-tails, the P-value for k is computed directly from the fitted model's upper tail,
+// in time that doesn't grow with k, instead of from the pmfs for 0..k and a tail sum.
+// Each result is kept until the fit changes, since the same few counts are typically looked up repeatedly.
+long double BackgroundRegionManager::closedFormPvalue(const unsigned int& k)
+{
+  if (k >= m_closedFormPvals.size())
+    {
+      m_closedFormPvals.resize(k + 1);
+      m_closedFormPvalFits.resize(k + 1, 0);
+    }
+  if (m_closedFormPvalFits[k] == m_fitNumber)
+    return m_closedFormPvals[k];
+
+  long double pval;
+  if (0 == k)
+    pval = 1.;
+  else if (&nextProbNegativeBinomial == m_pmf)
+    pval = upperTailNegativeBinomial(k, m_pmfParams);
+  else if (&nextProbBinomial == m_pmf)
+    pval = upperTailBinomial(k, m_pmfParams);
+  else
+    pval = upperTailPoisson(k, m_pmfParams);
+  if (pval < m_minPvalue)
+    pval = m_minPvalue;
+  m_closedFormPvals[k] = pval;
+  m_closedFormPvalFits[k] = m_fitNumber;
+  return pval;
+}
+
+// Adds the bin for count k (== m_distn.size()), which has no sampled observations,
+// to the end of the distribution, and completes the moving average that it ends.
+void BackgroundRegionManager::appendBin(const int& k, const long double& pmf)
+{
+  m_distn.push_back(0, pmf); // be sure not to increment m_sampledDataDistnSize...
+  m_runStats.noteDistnSize(m_distn.size());
+  const int MAlenOver2(m_MAlength / 2);
+  if (k >= m_MAlength)
+    m_distn.setMAxN(k - MAlenOver2, m_distn.MAxN[k - MAlenOver2 - 1] - m_distn.numOccs[k - m_MAlength] + m_distn.numOccs[k]);
+  else
+    {
+      if (m_MAlength - 1 == k)
+        {
+          int sum(0);
+          for (int j = 0; j <= k; j++)
+            sum += m_distn.numOccs[j];
+          m_distn.setMAxN(MAlenOver2, sum);
+        }
+    }
+}
+
+// Translate the current model (m_pmf, m_pmfParams) into the coefficients used by the double kernels.
+void BackgroundRegionManager::setPmfCoefficients(const long double& prob0)
+{
+  const vector<long double>& p(m_pmfParams);
+  m_pmfCoeffs.kMax = numeric_limits<int>::max() - 1;
+  if (&nextProbPoisson == m_pmf)
+    {
+      m_pmfCoeffs.A = static_cast<double>(p[0]);
+      m_pmfCoeffs.B = 0.;
+    }
+  else if (&nextProbNegativeBinomial == m_pmf) // p = m, r
+    {
+      m_pmfCoeffs.A = static_cast<double>(p[0] * (p[1] - 1.) / (p[1] + p[0]));
+      m_pmfCoeffs.B = static_cast<double>(p[0] / (p[1] + p[0]));
+    }
+  else // binomial; p = m, v, n
+    {
+      m_pmfCoeffs.A = static_cast<double>((p[0] - p[1]) * (p[2] + 1.) / p[1]);
+      m_pmfCoeffs.B = static_cast<double>(-(p[0] - p[1]) / p[1]);
+      m_pmfCoeffs.kMax = p[2] < numeric_limits<int>::max() - 1 ? static_cast<int>(p[2] + 0.5) : numeric_limits<int>::max() - 1; // n is a whole number
+    }
+  m_prob0D = static_cast<double>(prob0);
+}
+
+// The double-precision counterpart of the pmf and P-value computations in computeStats() and getPvalue():
+// fills m_pmfD for kFirstNewPmf <= k <= kLast, seeded with m_distn.pmf[kFirstNewPmf-1] (or prob0),
+// takes the pmfs below kFirstNewPmf from m_distn, and fills m_pvalD for kLowestPval <= k <= kLast.  Double arithmetic, unlike the x87 long double arithmetic
+// of the other path, can be vectorized; see pmfRatios() and tailFactor().
+// If the P-value floor (--min-pvalue) is reached along the way, kLast and m_kFloor are set to that k.
+// Returns false if the values would fall below the smallest normal double;
+// the caller then uses the long double path instead.
+bool BackgroundRegionManager::computePvaluesDouble(const int& kFirstNewPmf, int& kLast, const int& kLowestPval)
+{
+  if (static_cast<int>(m_pmfD.size()) <= kLast)
+    {
+      m_pmfD.resize(kLast + 1);
+      m_pvalD.resize(kLast + 1, -1.);
+    }
+  int k(kFirstNewPmf);
+  if (0 == k)
+    {
+      m_pmfD[0] = m_prob0D;
+      k = 1;
+    }
+  else
+    {
+      for (int j = min(kLowestPval, k - 1); j < k; j++)
+        m_pmfD[j] = static_cast<double>(m_distn.pmf[j]);
+    }
+  // With a P-value floor, the pmfs are computed a block at a time, so that few are computed beyond it.
+  const int BLOCK_SIZE(64);
+  const bool findFloor(m_doubleKernels && m_minPvalue > 0); // with --verify-precision, the long double path decides where the floor is
+  double ratios[BLOCK_SIZE];
+  int kTop(kLast), kFloor(-1);
+  while (k <= kTop)
+    {
+      const int kBlock(k), n(min(BLOCK_SIZE, kTop - k + 1));
+      pmfRatios(m_pmfCoeffs, k, n, ratios);
+      for (int i = 0; i < n; i++, k++)
+        m_pmfD[k] = m_pmfD[k - 1] * ratios[i];
+      m_runStats.numPmfTerms += n;
+      if (findFloor)
+        {
+          for (int j = max(kBlock, m_kFloorSearchStart); j < k; j++)
+            if (m_pmfD[j] <= m_minPvalue && m_pmfD[j] * tailFactor(m_pmfCoeffs, j) <= m_minPvalue)
+              {
+                kTop = kFloor = j;
+                break;
+              }
+        }
+    }
+
+  // Below the smallest normal double, precision gets lost and then values vanish altogether,
+  // whereas long double carries on to ~1e-4931.  The pmfs computed here can only be that small
+  // if the one they start from is, or if the last P-value is (the pmf decreases beyond its mode),
+  // and the P-values decrease with k, so checking those two values suffices.
+  if (m_pmfD[kFirstNewPmf > 0 ? kFirstNewPmf - 1 : 0] < numeric_limits<double>::min())
+    return false;
+  double pval(m_pmfD[kTop] * tailFactor(m_pmfCoeffs, kTop));
+  if (pval < numeric_limits<double>::min())
+    return false;
+  m_pvalD[kTop] = pval;
+  for (k = kTop; k > max(kLowestPval, 1); k--)
+    m_pvalD[k - 1] = pval = m_pmfD[k - 1] + pval;
+  if (0 == kLowestPval)
+    m_pvalD[0] = 1.;
+  kLast = kTop;
+  if (-1 != kFloor)
+    m_kFloor = kFloor;
+  return true;
+}
+
+// Copy the values computed by computePvaluesDouble() into m_distn (toDistn == true),
+// or vice versa.
+void BackgroundRegionManager::copyPvaluesDouble(const int& kFirstNewPmf, const int& kLast, const int& kLowestPval, const bool& toDistn)
+{
+  if (static_cast<int>(m_pmfD.size()) <= kLast)
+    {
+      m_pmfD.resize(kLast + 1);
+      m_pvalD.resize(kLast + 1, -1.);
+    }
+  for (int k = kFirstNewPmf; k <= kLast; k++)
+    {
+      if (toDistn)
+        m_distn.pmf[k] = m_pmfD[k];
+      else
+        m_pmfD[k] = static_cast<double>(m_distn.pmf[k]);
+    }
+  for (int k = kLowestPval; k <= kLast; k++)
+    {
+      if (toDistn)
+        m_distn.pval[k] = m_pvalD[k];
+      else
+        m_pvalD[k] = m_distn.pval[k];
+    }
+}
+
+// This method gets called at the end of a chromosome, at the end of a file,
+// and anytime there's a gap in the data that's wider than half the background window width.
+// It computes P-values for all sites in the current background window that need them,
+// passes them along, and "flushes" the distribution (deletes it, resets accompanying variables).
+void BackgroundRegionManager::computePandFlush(SiteManager& sm)
+{
+ if (m_distn.empty())
+    return;
+  m_runStats.numFlushes++;
+
+  if (!m_sliding || m_needToUpdate_kcutoff)
+    {
+      // Moving averages need to be computed, m_kcutoff needs to be determined,
+      // mean and variance need to be computed, and all pmfs need to be computed.
+      findCutoff(RunStats::CUTOFF_AT_FLUSH);
+    }
+
+  computeStats(-1, RunStats::FIT_AT_FLUSH); // -1 means "for all observed values of k"
+
+  // Both halves, left to right.
+  for (unsigned long i = 0; i < m_sitesInRegion.size(); i++)
+    {
+      const SiteData& site = m_sitesInRegion.at(i);
+      if (!site.hasPval)
+        {
+          long double pval;
+          if (m_pmf != NULL)
+            pval = getPvalue(site.count);
+          else
+            pval = 999.;
+	  sm.processPvalue(pval // pass this P-value along to the corresponding site
+#ifdef DEBUG
+			   , site.sampled
+#endif
+			   );
+	}
+    }
+  reset();
+}
+
+// Empties the background window, and forgets the null model fitted to it.
+void BackgroundRegionManager::reset(void)
+{
+  m_sitesInRegion.clear();
+  m_distn.clear();
+  m_posL = m_posC = m_posR = -1;
+  m_pCurChrom = NULL;
+  m_runningSum_count = m_runningSum_countSquared = 
+    m_runningSum_count_duringPrevComputation = m_runningSum_countSquared_duringPrevComputation = 0;
+  m_numPtsInNullRegion = m_numPtsInNullRegion_duringPrevComputation = 0;
+  m_modeYval = m_modeXval = m_kcutoff = m_kTrendReversal = -1;
+  m_sliding = false;
+  m_needToUpdate_kcutoff = true;
+
+  m_minMAxN = -1;
+
+  m_prev_k = m_kFloor = -1;
+  m_pCurTable = NULL;
+  m_pmf = NULL;
+  m_pmfParams.clear();
+  m_nextPosToSample = -1;
+  m_sampledDataDistnSize = 0;
+}
+
+// Replaces this manager's window with a copy of brm's (which must be sliding), with the distribution of counts
+// rebuilt from the sampled sites, so that the statistics can be computed from scratch, as for a new window.
+void BackgroundRegionManager::rebuildFrom(BackgroundRegionManager& brm)
+{
+  reset();
+  setBounds(brm.m_pCurChrom, brm.m_posL, brm.m_posR);
+  for (unsigned long i = 0; i < brm.m_sitesInRegion.size(); i++)
+    {
+      const SiteData& sd = brm.m_sitesInRegion.at(i);
+      if (sd.sampled)
+        {
+          while (static_cast<int>(m_distn.size()) <= sd.count)
+            m_distn.push_back(0);
+          m_distn.numOccs[sd.count]++;
+        }
+      if (sd.pos < m_posC)
+        m_sitesInRegion.pushLeft(sd);
+      else
+        m_sitesInRegion.pushRight(sd);
+    }
+  m_sampledDataDistnSize = static_cast<int>(m_distn.size());
+}
+
+// --verify:  the histogram, cutoff, running sums (i.e., mean and variance) and P-value of the central count k,
+// all maintained incrementally as the window slides, are recomputed from scratch for the current window
+// by m_pReference, and the run is aborted with a list of the differences if any of them disagree.
+// A P-value depends slightly on how far the pmfs were computed when it was (see computeStats()),
+// so the P-values only have to agree to well within the precision of tailSum().
+void BackgroundRegionManager::verify(const int& k, const long double& pval)
+{
+  const long double PVALUE_TOLERANCE(1.0e-4); // relative
+  const int MAX_BINS_LISTED(10);
+  BackgroundRegionManager& ref(*m_pReference);
+  ref.rebuildFrom(*this);
+  ref.findCutoff(RunStats::CUTOFF_AT_WINDOW_START);
+  // Ties for the mode of the moving sums are broken to the right while sliding, but to the left at the start
+  // of a window.  If the sliding mode is one of the tied maxima, search for the cutoff from it instead.
+  if (m_modeXval != ref.m_modeXval && m_modeXval >= 0 && m_modeXval < ref.m_sampledDataDistnSize
+      && ref.m_distn.MAxN[m_modeXval] == ref.m_modeYval)
+    {
+      ref.m_modeXval = m_modeXval;
+      ref.m_sliding = true; // so that the moving sums, and this mode, are kept
+      ref.findCutoff(RunStats::CUTOFF_ON_SLIDE);
+    }
+  ref.computeStats(-1, RunStats::FIT_AT_WINDOW_START);
+  const long double refPval(ref.m_pmf != NULL ? ref.getPvalue(k) : 999.);
+  m_runStats.numVerifications++;
+
+  ostringstream diffs;
+  diffs.precision(10);
+  if (m_sampledDataDistnSize != ref.m_sampledDataDistnSize)
+    diffs << "  histogram size:  " << m_sampledDataDistnSize << " (sliding), " << ref.m_sampledDataDistnSize << " (from scratch)\n";
+  int numBinDiffs(0);
+  for (int i = 0; i < max(m_sampledDataDistnSize, ref.m_sampledDataDistnSize); i++)
+    {
+      const int n(i < m_sampledDataDistnSize ? m_distn.numOccs[i] : 0);
+      const int nRef(i < ref.m_sampledDataDistnSize ? ref.m_distn.numOccs[i] : 0);
+      if (n != nRef && ++numBinDiffs <= MAX_BINS_LISTED)
+        diffs << "  occurrences of count " << i << ":  " << n << " (sliding), " << nRef << " (from scratch)\n";
+    }
+  if (numBinDiffs > MAX_BINS_LISTED)
+    diffs << "  ...and " << numBinDiffs - MAX_BINS_LISTED << " more counts' occurrences\n";
+  if (m_kcutoff != ref.m_kcutoff)
+    diffs << "  cutoff:  " << m_kcutoff << " (sliding), " << ref.m_kcutoff << " (from scratch)\n";
+  if (m_numPtsInNullRegion != ref.m_numPtsInNullRegion)
+    diffs << "  sites in the null region:  " << m_numPtsInNullRegion << " (sliding), " << ref.m_numPtsInNullRegion << " (from scratch)\n";
+  if (m_runningSum_count != ref.m_runningSum_count)
+    diffs << "  sum of their counts:  " << m_runningSum_count << " (sliding), " << ref.m_runningSum_count << " (from scratch)\n";
+  if (m_runningSum_countSquared != ref.m_runningSum_countSquared)
+    diffs << "  sum of their squared counts:  " << m_runningSum_countSquared << " (sliding), " << ref.m_runningSum_countSquared << " (from scratch)\n";
+  if (fabs(pval - refPval) > PVALUE_TOLERANCE * max(pval, refPval))
+    diffs << "  P-value of the central count, " << k << ":  " << pval << " (sliding), " << refPval << " (from scratch)\n";
+  if (diffs.str().empty())
+    return;
+  // The cutoff is found by searching the moving sums to the right of their mode, so list those too.
+  diffs << "  mode of the moving sums:  " << m_modeXval << " (sliding), " << ref.m_modeXval << " (from scratch)\n"
+        << "  trend reversal:  " << m_kTrendReversal << " (sliding), " << ref.m_kTrendReversal << " (from scratch)\n";
+
+  cerr << "Error:  --verify found that the statistics maintained while sliding the background window "
+       << *m_pCurChrom << ':' << m_posL << '-' << m_posR << " (centered at " << m_posC << ")\n"
+       << "disagree with those recomputed from scratch for it:\n"
+       << diffs.str()
+       << endl;
+  exit(1);
+}
+
+// If there's an observation at the central position of the background window,
+// this method computes (or looks up) its P-value and passes it along, and returns true.
+// The pmfs are recomputed from k=0 if needToComputePMFs == true or the mean and/or variance have changed
+// since they were last computed, in which case needToComputePMFs gets set to false.
+// After a batch of numSlides slides (see slideRun()), the P-value is passed along for the central site
+// and for the numSlides-1 sites before it, which must all have the same count and the same null model.
+bool BackgroundRegionManager::assignPvalueToCentralSite(SiteManager& sm, bool& needToComputePMFs,
+							const long& numSlides)
+{
+  SiteData& central = m_sitesInRegion.rightFront();
+  m_numSlidesSinceVerify += numSlides;
+  if (central.pos != m_posC)
+    return false;
+
+  if (m_runningSum_countSquared_duringPrevComputation != m_runningSum_countSquared || m_runningSum_count_duringPrevComputation != m_runningSum_count || m_numPtsInNullRegion_duringPrevComputation != m_numPtsInNullRegion)
+    needToComputePMFs = true; // mean and/or variance have changed; won't change if added and removed k > m_kcutoff
+  if (needToComputePMFs)
+    {
+      m_prev_k = -1; // compute pmfs from k=0 through current k
+      computeStats(central.count, RunStats::FIT_ON_CHANGE); // sets m_prev_k = central.count
+      needToComputePMFs = false;
+    }
+  else // We've calculated pmfs for this distribution, but it's possible we haven't computed one for a k this large.
+    if (m_prev_k != -1 && central.count > m_prev_k)
+      {
+        // Only pmfs for k <= m_prev_k have been computed and stored, to save time.
+        // Still need to compute the pmfs for m_prev_k < k <= this k.
+        computeStats(central.count, RunStats::FIT_EXTENSION); // sets m_prev_k = central.count
+        needToComputePMFs = false;
+      }
+  long double pval;
+  if (m_pmf != NULL)
+    pval = getPvalue(central.count);
+  else
+    pval = 999.;
+  if (m_pReference && m_numSlidesSinceVerify >= m_verifyInterval)
+    {
+      verify(central.count, pval);
+      m_numSlidesSinceVerify = 0;
+    }
+  // pass this P-value along for the corresponding site(s)
+  sm.processPvalues(pval, numSlides
+#ifdef DEBUG
+		    , central.sampled
+#endif
+		    );
+  central.hasPval = true;
+  for (long i = 1; i < numSlides; i++)
+    m_sitesInRegion.at(m_sitesInRegion.leftSize() - i).hasPval = true;
+  return true;
+}
+
+// This method gets called to start sliding the background window (m_sliding == false) or perform a slide.
+// It computes a P-value for the site at the center of the background window, when present,
+// and it slides the background rightward.
+// For the initial slide (e.g., the initial background window on a chromosome),
+// it also computes P-values for all sites in the left half of the background window.
+//
+// Strictly speaking, if m_sliding == false and the incoming site lands at the right boundary,
+// no "slide" is performed, just an append operation and computations.
+void BackgroundRegionManager::slideAndCompute(const SiteRange& s, SiteManager& sm)
+{
+  if (m_posR > s.endPos)
+    {
+      cerr << "Coding error:  line " << __LINE__ << ", slideAndCompute window = " << *m_pCurChrom << ':'
+           << m_posL << '-' << m_posR << '\n'
+           << "erroneously received incoming position = " << s.endPos << "." << endl
+           << endl;
+      exit(1);
+    }
+
+  SiteData sd;
+  sd.pos = s.endPos;
+  sd.count = s.count;
+  sd.hasPval = false;
+  sd.sampled = false;
+
+  if (!m_sliding)
+    {
+      // When m_sliding == false, this function, slideAndCompute,
+      // really functions as "add and compute."
+      if (s.endPos == m_posR)
+        {
+          add(s); // append this site
+          sm.addSite(s);
+        }
+
+      findCutoff(RunStats::CUTOFF_AT_WINDOW_START); // because !m_sliding, findCutoff() will compute all moving averages
+      computeStats(-1, RunStats::FIT_AT_WINDOW_START); // -1 means compute "for all count values"
+
+      // P-values have been computed for all counts observed in this region.
+      // Assign these P-values to the counts observed in the left half of this region
+      // (i.e., assign to all points to the left of the central bp of this region).
+      for (unsigned long i = 0; i < m_sitesInRegion.leftSize(); i++)
+        {
+          SiteData& site = m_sitesInRegion.at(i);
+          long double pval;
+          if (m_pmf != NULL)
+            pval = getPvalue(site.count);
+          else
+            pval = 999.;
+	  sm.processPvalue(pval
+#ifdef DEBUG
+			   , site.sampled
+#endif
+			   );
+          site.hasPval = true;
+        }
+
+      // The region is centered on a specific position.
+      // If data was observed for that position (this is usually true),
+      // assign a P-value for that count at that position.
+      // P-values for positions to the right of this position
+      // will be determined later, one position at a time,
+      // as the region "slides" rightward and new positions, in turn,
+      // become the central position.
+      if (m_sitesInRegion.rightFront().pos == m_posC)
+        {
+          long double pval;
+          if (m_pmf != NULL)
+            pval = getPvalue(m_sitesInRegion.rightFront().count);
+          else
+            pval = 999.;
+	  
+	  // pass this P-value along for the corresponding site
+	  sm.processPvalue(pval
+#ifdef DEBUG
+			   , m_sitesInRegion.rightFront().sampled
+#endif
+			   );
+          m_sitesInRegion.rightFront().hasPval = true;
+        }
+      m_sliding = true;
+
+      if (s.endPos == m_posR)
+        return;
+
+      // else proceed to slide this region
+    } // End of if (!m_sliding).  Note that m_sliding is now true.
+
+  int idxMin(-1), idxMax(-1);
+  bool updateDistn(false);
+
+  // If we reach here, we're about to perform a 1bp slide.
+  // Either we need to perform several 1bp slide events
+  // until the next 1bp slide event brings in pos == s.endPos,
+  // or we're now going to slide 1bp and bring in pos == s.endPos.
+  bool needToComputePMFs(false);
+
+  if (m_needToUpdate_kcutoff)
+    {
+      cerr << "Coding error:  slideAndCompute(), m_sliding == true, line "
+           << __LINE__ << ", expected m_needToUpdate_kcutoff = false, but it's true.\n"
+           << "Region = ";
+      cerr << *m_pCurChrom << ':'
+           << "[" << m_posL << ',' << m_posC << ',' << m_posR
+           << "], incoming pos = " << s.endPos << ", k_c = " << m_kcutoff
+           << endl;
+      exit(1);
+    }
+
+  while (m_posR + 1 < s.endPos)
+    {
+      // Pop from the left half and update if necessary.
+      if (m_sitesInRegion.leftFront().pos == m_posL)
+        {
+          int prevModeXval(m_modeXval);
+          const int k = m_sitesInRegion.leftFront().count;
+          updateDistn = m_sitesInRegion.leftFront().sampled;
+
+          m_sitesInRegion.popLeft();
+
+          if (updateDistn)
+            {
+              // Update the values used to compute the mean and variance of the estimated null distribution.
+              if (k <= m_kcutoff)
+                {
+                  m_runningSum_count -= static_cast<long>(k);
+                  m_runningSum_countSquared -= static_cast<long>(k * k);
+                  m_numPtsInNullRegion--;
+                }
+              m_distn.numOccs[k]--;
+              // Update moving averages (technically, moving sums, not averages, because we're not dividing them by N).
+              idxMin = max(k - m_MAlength / 2, m_MAlength / 2);
+              idxMax = min(k + m_MAlength / 2, m_sampledDataDistnSize - 1 - m_MAlength / 2);
+              for (int i = idxMin; i <= idxMax; i++)
+                {
+                  m_distn.setMAxN(i, m_distn.MAxN[i] - 1);
+                  if (i == m_modeXval) // note that m_modeXval could be -1, in which case i can't equal it
+                    {
+                      m_modeYval--;
+                      // Check whether this subtraction reveals a new mode to the left or right of it.
+                      for (int j = m_MAlength / 2; j < m_sampledDataDistnSize - m_MAlength / 2; j++)
+                        {
+                          if (m_distn.MAxN[j] > m_modeYval)
+                            {
+                              m_modeXval = j;
+                              m_modeYval = m_distn.MAxN[j];
+                              m_needToUpdate_kcutoff = true;
+                            }
+                        }
+                    }
+                }
+
+              if (0 == m_distn.numOccs[k] && k == m_sampledDataDistnSize - 1)
+                {
+                  // The bin at the end of the count distribution/histogram is now empty.
+                  // Delete it, and delete any empty bins immediately preceding it,
+                  // so that the highest bin contains at least one observation.
+                  // If m_samplingInterval != 1 and m_distn.size() > m_sampledDataDistnSize,
+                  // delete all the excess bins in the upper tail for simplicity's sake.
+                  // (Such bins, each with numOccs == 0, will exist when, e.g.,
+                  // only observations with k <= 18 have been "sampled" for use
+                  // in the distribution, but k == 23, unsampled, was nonetheless observed,
+                  // and a P-value was computed for it.
+                  while (!m_distn.empty() && 0 == m_distn.numOccs.back())
+                    m_distn.pop_back();
+                  m_sampledDataDistnSize = static_cast<int>(m_distn.size());
+                  // Because we've deleted 1+ bins from the end of m_distn,
+                  // 1+ moving averages at the end of m_distn are now undefined.
+                  // (This will occur infrequently.)
+                  // Mark them as such for bookkeeping's sake.
+                  for (int i = m_sampledDataDistnSize - 1; i > m_sampledDataDistnSize - 1 - m_MAlength / 2 && i > -1; i--)
+                    m_distn.setMAxN(i, -1);
+                  // If we deleted the bin corresponding to m_kcutoff,
+                  // update m_kcutoff so that it's within range.
+                  // Let findCutoff() do this, so all appropriate variables will get updated.
+                  if (m_kcutoff >= m_sampledDataDistnSize)
+                    m_needToUpdate_kcutoff = true;
+                  // Bring idxMax back within range if necessary, now that m_distn.size() has decreased.
+                  if (idxMax > m_sampledDataDistnSize - 1 - m_MAlength / 2)
+                    idxMax = m_sampledDataDistnSize - 1 - m_MAlength / 2; // idxMax might now be < idxMin; ok if so
+                }
+
+              if (!m_needToUpdate_kcutoff) // then perform some additional tests and maybe set m_needToUpdate_kcutoff = true
+                {
+                  if (m_modeXval != prevModeXval || m_sampledDataDistnSize - 1 == m_kcutoff)
+                    m_needToUpdate_kcutoff = true; // for safety's sake, at least
+                  else
+                    {
+                      const int halfMAlength = m_MAlength / 2;
+                      if (0 == m_minMAxN)
+                        {
+                          // The subtraction might have created a new instance of 0 == m_minMAxN at some k < m_kcutoff,
+                          // or lowered an MAxN value enough that one to its right now marks a "trend reversal"
+                          // (observed via --verify:  MAxN = 3 at k = 38 and 4 at k = 39, with m_kcutoff = 48).
+                          if (k + halfMAlength > m_modeXval + 1 && k - halfMAlength < m_kcutoff)
+                            m_needToUpdate_kcutoff = true;
+                        }
+                      else
+                        {
+                          if (-1 == m_kTrendReversal)
+                            {
+                              cerr << "Coding error:  m_kTrendReversal should NOT be -1 on line " << __LINE__ << "." << endl;
+                              exit(1);
+                            }
+                          if (k + halfMAlength > m_modeXval + 1 && k - halfMAlength <= m_kTrendReversal)
+                            m_needToUpdate_kcutoff = true; // possibly overkill, but worth doing for safety's sake
+                        }
+                    }
+                }
+            } // end of "if (updateDistn)"
+        } // end of "if m_sitesInRegion.leftFront().pos == m_posL"
+
+      // When we have an observation for the central position,
+      // move it from the leftmost position in the right half
+      // to the rightmost position in the left half.
+      if (m_sitesInRegion.rightFront().pos == m_posC)
+        {
+          m_sitesInRegion.advanceCentre();
+        }
+      m_posL++;
+      m_posC++;
+      m_posR++;
+
+      if (m_needToUpdate_kcutoff)
+        {
+          findCutoff(RunStats::CUTOFF_IN_GAP); // sets m_needToUpdate_kcutoff = false
+          needToComputePMFs = true;
+        }
+
+      assignPvalueToCentralSite(sm, needToComputePMFs, 1); // if there's an observation there
+    } // end of "while sliding and not bringing in any new observations because there's missing data there"
+
+  // If we reach here,
+  // we're about to slide 1bp and bring in pos == m_posR + 1.
+
+  m_sitesInRegion.pushRight(sd); // process its addition to m_distn below
+  sm.addSite(s);
+  if (1 != m_samplingInterval)
+    {
+      if (s.endPos > m_nextPosToSample)
+        m_nextPosToSample = s.endPos;
+
+      // Alternatively, "sampling" could be performed strictly at multiples of m_samplingInterval.
+      // If we intend to sample at, say, positions 200, 400, 600, 800, 1000, etc.,
+      // and regions 390-402 and 598-620 are excluded (unmappable),
+      // then the current code will sample at 200, 403, 621, 821, etc.
+      // Sampling strictly at multiples of m_samplingInterval would in this case
+      // sample at 200, 800, 1000, etc.
+      // Use the following code if strict multiples of m_samplingInterval are desired.
+      //
+      // m_nextPosToSample += static_cast<int>(ceil(static_cast<double>(s.endPos - m_nextPosToSample)/static_cast<double>(m_samplingInterval))) * m_samplingInterval;
+      //
+      // The above is a one-step version of "while(s.endPos > m_nextPosToSample){m_nextPosToSample += m_samplingInterval;}."
+      // Typically, m_nextPosToSample will only need to increase by m_samplingInterval;
+      // it will need to increase by a greater multiple of m_samplingInterval when a large gap is present in the data
+      // (an unmappable region or otherwise restricted/withheld region).
+
+      if (s.endPos == m_nextPosToSample)
+        {
+          m_sitesInRegion.rightBack().sampled = true;
+          m_nextPosToSample += m_samplingInterval;
+        }
+    }
+  else
+    m_sitesInRegion.rightBack().sampled = true;
+  // increment m_posR below
+
+  if (m_needToUpdate_kcutoff)
+    {
+      cerr << "Coding error:  slideAndCompute(), m_sliding == true, line "
+           << __LINE__ << ", successfully slid through missing data, expected m_needToUpdate_kcutoff = false, but it's true.\n"
+           << "Region = ";
+      cerr << *m_pCurChrom << ':'
+           << "[" << m_posL << ',' << m_posC << ',' << m_posR
+           << "], incoming pos = " << s.endPos << ", k_c = " << m_kcutoff
+           << endl;
+      exit(1);
+    }
+
+  // If there's an observation exiting the region whose count
+  // equals that of the observation entering the region,
+  // and both were sampled,
+  // the distribution remains unchanged, and no calculations need to be made,
+  // unless the necessary calculations were postponed during a previous execution of this method.
+  if (m_sitesInRegion.leftFront().pos == m_posL && m_sitesInRegion.leftFront().count == s.count && m_sitesInRegion.leftFront().sampled && m_sitesInRegion.rightBack().sampled)
+    {
+      m_sitesInRegion.popLeft();
+      // When we have an observation for the central position,
+      // move it from the leftmost position in the right half
+      // to the rightmost position in the left half.
+      if (m_sitesInRegion.rightFront().pos == m_posC)
+        {
+          m_sitesInRegion.advanceCentre();
+        }
+      m_posL++;
+      m_posC++;
+      m_posR++;
+      // Assign P-value for m_posC if necessary.
+      // needToComputePMFs should only be true here if we previously pop_fronted k < m_kcutoff without push_backing
+      // (due to missing data at the right edge), and additionally,
+      // there was missing data at m_posC, so no pmfs were computed.
+      assignPvalueToCentralSite(sm, needToComputePMFs, 1);
+
+      return;
+    }
+
+  // If we reach here,
+  // we're adding a site at the right boundary.
+  // We might be removing one from the left boundary (probably so).
+  // If an observed site slides into the center position,
+  // we'll have to compute a P-value for it.
+  // (Or assign one from the current distribution
+  // in the unlikely event of incoming and outgoing sites
+  // both having high counts in what has been declared an upper tail beyond the null.)
+
+  int k_incoming = s.count;
+  int k_outgoing = -1;
+  int origModeXval(m_modeXval);
+  int origDistnSize(m_sampledDataDistnSize);
+
+  if (m_sitesInRegion.leftFront().pos == m_posL)
+    {
+      if (m_sitesInRegion.leftFront().sampled)
+        k_outgoing = m_sitesInRegion.leftFront().count;
+      m_sitesInRegion.popLeft();
+    }
+  if (k_outgoing != -1)
+    {
+      // Update the values used to compute the mean and variance of the estimated null distribution.
+      if (k_outgoing <= m_kcutoff)
+        {
+          m_runningSum_count -= static_cast<long>(k_outgoing);
+          m_runningSum_countSquared -= static_cast<long>(k_outgoing * k_outgoing);
+          m_numPtsInNullRegion--;
+        }
+      m_distn.numOccs[k_outgoing]--;
+      if (0 == m_distn.numOccs[k_outgoing] && k_outgoing == m_sampledDataDistnSize - 1)
+        {
+          // The bin at the end of the count distribution/histogram is now empty.
+          // Delete it, and delete any empty bins immediately preceding it,
+          // so that the highest bin contains at least one observation.
+          // If m_samplingInterval != 1 and m_distn.size() > m_sampledDataDistnSize,
+          // delete all the excess bins in the upper tail for simplicity's sake.
+          // (Such bins, each with numOccs == 0, will exist when, e.g.,
+          // only observations with k <= 18 have been "sampled" for use
+          // in the distribution, but k == 23, unsampled, was nonetheless observed,
+          // and a P-value was computed for it.
+          while (!m_distn.empty() && 0 == m_distn.numOccs.back())
+            m_distn.pop_back();
+          m_sampledDataDistnSize = static_cast<int>(m_distn.size());
+          // Because we've deleted 1+ bins from the end of m_distn,
+          // 1+ moving averages at the end of m_distn are now undefined.
+          // (This will happen infrequently.)
+          // Mark them as such for bookkeeping's sake.
+          for (int i = m_sampledDataDistnSize - 1; i > m_sampledDataDistnSize - 1 - m_MAlength / 2 && i > -1; i--)
+            m_distn.setMAxN(i, -1);
+          if (origDistnSize >= m_MAlength && m_sampledDataDistnSize < m_MAlength)
+            {
+              // There are now too few bins to compute a MAxN of length m_MAlength, so the mode is undefined.
+              m_modeXval = m_modeYval = -1;
+            }
+          // If we deleted the bin corresponding to m_kcutoff,
+          // update m_kcutoff so that it's within range.
+          // Let findCutoff() do this, so all appropriate variables will get updated.
+          if (m_kcutoff >= m_sampledDataDistnSize)
+            m_needToUpdate_kcutoff = true;
+          // Now redefine "origDistnSize" so that it's correct with respect to k_incoming, which might replace deleted bin(s) and add new ones.
+          origDistnSize = m_sampledDataDistnSize;
+        }
+
+      // Update moving averages (technically, moving sums, not averages, because we're not dividing them by N).
+      idxMin = max(k_outgoing - m_MAlength / 2, m_MAlength / 2);
+      idxMax = min(k_outgoing + m_MAlength / 2, m_sampledDataDistnSize - 1 - m_MAlength / 2);
+      for (int i = idxMin; i <= idxMax; i++)
+        {
+          m_distn.setMAxN(i, m_distn.MAxN[i] - 1);
+          if (i == m_modeXval)
+            {
+              m_modeYval--;
+              // There's a small chance that this subtraction has moved the mode leftward or rightward.
+              for (int j = m_MAlength / 2; j < m_sampledDataDistnSize - m_MAlength / 2; j++)
+                {
+                  if (m_distn.MAxN[j] > m_modeYval || (j > m_modeXval && m_distn.MAxN[j] == m_modeYval))
+                    {
+                      m_modeXval = j;
+                      m_modeYval = m_distn.MAxN[j];
+                    }
+                }
+            }
+        }
+    }
+  m_posL++;
+
+  // Note:  The incoming site was pushed onto the end of the right half of m_sitesInRegion above, hence no need to do it here.
+  m_posR++;
+
+  if (m_sitesInRegion.rightBack().sampled)
+    {
+      // Update the values used to compute the mean and variance of the estimated null distribution.
+      if (k_incoming <= m_kcutoff)
+        {
+          m_runningSum_count += k_incoming;
+          m_runningSum_countSquared += k_incoming * k_incoming;
+          m_numPtsInNullRegion++;
+        }
+      if (k_incoming < m_sampledDataDistnSize)
+        m_distn.numOccs[k_incoming]++; // NOTE:  Still need to update MAxN values; will do that below.
+      else
+        {
+          // Add bins to m_distn.         NOTE:  MAxN values get updated here in this case.
+          int startHere = m_sampledDataDistnSize - m_MAlength / 2;
+
+          while (m_sampledDataDistnSize < k_incoming && m_sampledDataDistnSize < static_cast<int>(m_distn.size()))
+            m_sampledDataDistnSize++;
+          if (m_sampledDataDistnSize < static_cast<int>(m_distn.size()))
+            {
+              m_distn.numOccs[m_sampledDataDistnSize] = 1;
+              m_sampledDataDistnSize++;
+            }
+          else
+            {
+              while (static_cast<int>(m_distn.size()) < k_incoming)
+                m_distn.push_back(0); // create bins for unobserved interior values, e.g., count = 5 but only 0,1,2 have been observed so far
+              m_distn.push_back(1);
+              m_sampledDataDistnSize = static_cast<int>(m_distn.size());
+              m_runStats.noteDistnSize(m_distn.size());
+            }
+          if (startHere >= m_MAlength / 2) // then we have at least one valid MAxN value that we will now update
+            {
+              int sum(0);
+              int idxL(startHere - m_MAlength / 2), idxC(startHere), idxR(startHere + m_MAlength / 2);
+              for (int i = idxL; i <= idxR; i++)
+                sum += m_distn.numOccs[i];
+              m_distn.setMAxN(idxC, sum);
+              if (m_distn.MAxN[idxC] > m_modeYval) // also true when m_modeYval == m_modeXval == -1
+                {
+                  m_modeXval = idxC;
+                  m_modeYval = m_distn.MAxN[idxC];
+                }
+              idxR++;
+              while (idxR < m_sampledDataDistnSize)
+                {
+                  sum -= m_distn.numOccs[idxL++];
+                  sum += m_distn.numOccs[idxR++];
+                  idxC++;
+                  m_distn.setMAxN(idxC, sum);
+                  if (m_distn.MAxN[idxC] > m_modeYval) // also true when m_modeYval == m_modeXval == -1
+                    {
+                      m_modeXval = idxC;
+                      m_modeYval = m_distn.MAxN[idxC];
+                    }
+                }
+            }
+          else if (m_sampledDataDistnSize >= m_MAlength)
+            {
+              // m_distn contained very few bins before an observation of k_incoming slid into the current region,
+              // too few to compute any moving averages (times N, MAxN), but k_incoming is large enough
+              // that now, m_distn contains enough bins to compute at least one MAxN, maybe even several
+              // (e.g., m_distn had bins for k=0,1,2, and then k_incoming=6 suddenly slid into the region).
+              // So we need to fill in the rightmost MAxN value and work leftwards from there.
+              int stopHere = max(startHere, m_MAlength / 2 - 1);
+              startHere = m_sampledDataDistnSize - 1 - m_MAlength / 2;
+              int sum(0);
+              int idxL(startHere - m_MAlength / 2), idxC(startHere), idxR(startHere + m_MAlength / 2);
+              for (int i = idxL; i <= idxR; i++)
+                sum += m_distn.numOccs[i];
+              m_distn.setMAxN(idxC, sum);
+              if (m_distn.MAxN[idxC] > m_modeYval) // recall m_modeYval == -1 if there had been too few bins to compute a MAxN value
+                {
+                  m_modeXval = idxC;
+                  m_modeYval = m_distn.MAxN[idxC];
+                }
+              idxC--;
+              idxL--;
+              while (idxC != stopHere)
+                {
+                  sum -= m_distn.numOccs[idxR--];
+                  sum += m_distn.numOccs[idxL--];
+                  m_distn.setMAxN(idxC, sum);
+                  if (m_distn.MAxN[idxC] > m_modeYval) // >, not >=, because in the event of a tie, we want to choose the rightmost mode
+                    {
+                      m_modeXval = idxC;
+                      m_modeYval = m_distn.MAxN[idxC];
+                    }
+                  idxC--;
+                }
+            }
+        }
+
+      // If one or more bins were added to the end of m_distn because k_incoming was >= m_distn.size(),
+      // even if bins were deleted due to k_outgoing and replaced due to k_incoming,
+      // then the MAxN values are up-to-date with respect to k_incoming.
+      // Otherwise, update moving averages (technically, moving sums, not averages, because we're not dividing them by N)
+      // to reflect the addition of k_incoming.
+      if (m_sampledDataDistnSize <= origDistnSize) // <=, not ==, because k_outgoing could have caused shrinkage of m_distn.
+        {
+          idxMin = max(k_incoming - m_MAlength / 2, m_MAlength / 2);
+          idxMax = min(k_incoming + m_MAlength / 2, m_sampledDataDistnSize - 1 - m_MAlength / 2);
+          for (int i = idxMin; i <= idxMax; i++)
+            {
+              m_distn.setMAxN(i, m_distn.MAxN[i] + 1);
+              if (i == m_modeXval)
+                m_modeYval++;
+              else
+                {
+                  if (m_distn.MAxN[i] > m_modeYval)
+                    {
+                      m_modeXval = i;
+                      m_modeYval = m_distn.MAxN[i];
+                    }
+                  else if (i > m_modeXval && m_distn.MAxN[i] == m_modeYval)
+                    {
+                      // The addition has moved the mode rightward.
+                      m_modeXval = i;
+                      m_modeYval = m_distn.MAxN[i];
+                    }
+                }
+            }
+        }
+      else
+        {
+          // Bins were added to the end of m_distn; if m_kcutoff encompassed all of m_distn before, it needs to encompass the new bin(s) too.
+          if (origDistnSize - 1 == m_kcutoff)
+            m_needToUpdate_kcutoff = true;
+        }
+
+      // At this point, all MAxN values have been updated.
+
+      if (!m_needToUpdate_kcutoff)
+        {
+          // If the mode has changed, recompute everything.
+          if (m_modeXval != origModeXval)
+            m_needToUpdate_kcutoff = true;
+          else
+            {
+              if (m_sampledDataDistnSize - 1 == m_kcutoff)
+                m_needToUpdate_kcutoff = true; // Probably m_kcutoff won't change, but do a full check to make sure.
+              else
+                {
+                  if (0 == m_minMAxN)
+                    {
+                      if (m_distn.MAxN[m_kcutoff] != 0)
+                        {
+                          // m_kcutoff probably won't change, but it no longer has MAxN==0, so recompute.
+                          m_needToUpdate_kcutoff = true;
+                        }
+                      else
+                        {
+                          int halfMAlength = m_MAlength / 2;
+                          if (k_outgoing != -1 && k_outgoing + halfMAlength > m_modeXval + 1 && k_outgoing - halfMAlength < m_kcutoff)
+                            {
+                              // There's a tiny chance that the subtraction caused a bin left of m_kcutoff
+                              // to get its MAxN value reduced to 0, thereby moving m_kcutoff leftward,
+                              // or reduced it enough that an MAxN value to its right now marks a "trend reversal"
+                              // (observed via --verify:  MAxN = 3 at k = 38 and 4 at k = 39, with m_kcutoff = 48).
+                              m_needToUpdate_kcutoff = true;
+                            }
+                          // There's a tiny chance that an addition to the left of m_kcutoff (where MAxN == 0)
+                          // raised an MAxN value high enough that it is now higher than an MAxN value to its left
+                          // by more than the threshold.  This has been observed: m_kcutoff = 86 where MAxN = 0,
+                          // k = 47 has MAxN = 7, k = 51 has MAxN = 9 with 9 < 7*m_thresholdRatio, and then
+                          // k_incoming raises 51's MAxN from 9 to 10 without touching 47's MAxN,
+                          // so that 10 > 7*m_thesholdRatio and m_kcutoff needs to get set to k=47.
+                          // The same can happen when k_incoming's moving-average window ends just short of m_kcutoff
+                          // (observed via --verify:  MAxN = 2 at k = 90 and 3 at k = 91, with m_kcutoff = 96),
+                          // or straddles the mode.
+                          if (k_incoming + halfMAlength > m_modeXval + 1 && k_incoming - halfMAlength < m_kcutoff)
+                            m_needToUpdate_kcutoff = true;
+                        }
+                    }
+                  else
+                    {
+                      if (-1 == m_kTrendReversal)
+                        {
+                          cerr << "Coding error:  m_kTrendReversal should NOT be -1 on line " << __LINE__ << " of BRM::slideAndCompute()." << endl;
+                          cerr << "k_c = " << m_kcutoff << ", m_minMAxN = " << m_minMAxN << ", m_modeXval = "
+                               << m_modeXval << ", m_modeYval = " << m_modeYval
+                               << ", k_out = " << k_outgoing << ", k_in = " << k_incoming
+                               << ", region = ";
+                          cerr << *m_pCurChrom << ':'
+                               << "[" << m_posL << ',' << m_posC + 1 << ',' << m_posR << ']' << endl;
+                          cerr << "m_distn = {{0," << m_distn.numOccs[0] << ',' << m_distn.MAxN[0];
+                          for (unsigned int q = 1; q < m_distn.size(); q++)
+                            {
+                              if (0 == (q + 1) % 5)
+                                cerr << "},\n{" << q << ',' << m_distn.numOccs[q] << ',' << m_distn.MAxN[q];
+                              else
+                                cerr << "}, {" << q << ',' << m_distn.numOccs[q] << ',' << m_distn.MAxN[q];
+                            }
+                          cerr << "}}" << endl;
+                          exit(1);
+                        }
+                      // Prior to k_incoming and, when present, k_outgoing,
+                      // m_kcutoff's MAxN was a "global minimum so far" and m_kTrendReversal's MAxN
+                      // was sufficiently higher to define a "trend reversal."
+                      int halfMAlength = m_MAlength / 2;
+                      if (k_incoming + halfMAlength > m_modeXval + 1 && k_incoming - halfMAlength < m_kTrendReversal)
+                        m_needToUpdate_kcutoff = true; // possibly overkill, but worth doing for safety's sake
+                      if (k_outgoing != -1 && k_outgoing + halfMAlength > m_modeXval + 1 && k_outgoing - halfMAlength <= m_kTrendReversal)
+                        m_needToUpdate_kcutoff = true; // possibly overkill, but worth doing for safety's sake
+                    }
+                }
+            }
+        }
+    } // end of "if (m_sitesInRegion.rightBack().sampled)"
+
+  // When we have an observation for the central position,
+  // move it from the leftmost position in the right half
+  // to the rightmost position in the left half.
+  if (m_sitesInRegion.rightFront().pos == m_posC)
+    {
+      m_sitesInRegion.advanceCentre();
+    }
+  m_posC++;
+
+  if (m_needToUpdate_kcutoff)
+    {
+      findCutoff(RunStats::CUTOFF_ON_SLIDE); // sets m_needToUpdate_kcutoff = false
+      needToComputePMFs = true;
+    }
+
+  // Compute/assign P-value for m_posC if necessary.
+  if (!assignPvalueToCentralSite(sm, needToComputePMFs, 1))
+    {
+      // There's no observation corresponding to the central position in the region.
+      // Therefore we don't need to assign, or compute, a P-value.
+      // If m_needToUpdate_kcutoff == true, the computation will be done later.
+      // If m_needToUpdate_kcutoff == false but needToComputePMFs == true,
+      // we need to ensure that needToCompute will get triggered
+      // the next time any P-value needs to be assigned,
+      // either in a subsequent call to this method or in a call to the "compute and flush" one.
+      if (!m_needToUpdate_kcutoff && needToComputePMFs)
+        {
+          if (m_runningSum_countSquared == m_runningSum_countSquared_duringPrevComputation)
+            m_runningSum_countSquared_duringPrevComputation = -1; // this will ensure pmfs get computed next time
+        }
+    }
+}
+
+// This method brings the sites run.begPos+1 through run.endPos, which all have the same count
+// (e.g., the sites within one line of input), into the background window, with the same results
+// as that many calls to slideAndCompute().  The window must already be sliding.
+// Where the sites leaving at the left edge were sampled and have the same count as the incoming ones,
+// the null model doesn't change, so there's no histogram, moving-average, or cutoff bookkeeping;
+// and where, in addition, the sites arriving at the centre are contiguous and have the same count
+// (or there are none), they all get the same P-value.  Such a stretch is slid over in one step,
+// with one call to SiteManager::addSite() and one to SiteManager::processPvalues().
+// Only the positions where the outgoing, central, or incoming count changes are slid over 1 bp at a time,
+// by slideAndCompute().  Long runs of low counts make up most of the genome, so most slides are batched.
+// With --verify, batches are 1 bp wide, so every slide can be checked.
+void BackgroundRegionManager::slideRun(const SiteRange& run, SiteManager& sm)
+{
+  SiteRange s(run);
+  SiteData sd;
+  sd.count = run.count;
+  sd.hasPval = false;
+  sd.sampled = true;
+
+  long pos = run.begPos + 1;
+  while (pos <= run.endPos)
+    {
+      if (!m_sliding || m_samplingInterval != 1 || m_posR + 1 != pos || m_sitesInRegion.leftEmpty()
+          || m_sitesInRegion.leftFront().pos != m_posL || m_sitesInRegion.leftFront().count != run.count
+          || !m_sitesInRegion.leftFront().sampled)
+        {
+          s.begPos = pos - 1;
+          s.endPos = pos;
+          slideAndCompute(s, sm);
+          pos++;
+          continue;
+        }
+
+      // The outgoing sites:  identical counts leave as they enter; see the corresponding case in slideAndCompute().
+      const unsigned long leftSize(m_sitesInRegion.leftSize()), size(m_sitesInRegion.size());
+      long maxSlides(m_pReference ? 1 : run.endPos - pos + 1), numSlides(1);
+      while (numSlides < maxSlides && static_cast<unsigned long>(numSlides) < leftSize)
+        {
+          const SiteData& out = m_sitesInRegion.at(numSlides);
+          if (out.pos != m_posL + numSlides || out.count != run.count || !out.sampled)
+            break;
+          numSlides++;
+        }
+
+      // The central sites:  skip over the current one, which already has its P-value.
+      const unsigned long firstCentral(leftSize + (m_sitesInRegion.rightFront().pos == m_posC ? 1 : 0));
+      long numCentral(0);
+      if (firstCentral < size && m_sitesInRegion.at(firstCentral).pos == m_posC + 1)
+        {
+          const int centralCount(m_sitesInRegion.at(firstCentral).count);
+          numCentral = 1;
+          while (numCentral < numSlides && firstCentral + numCentral < size)
+            {
+              const SiteData& c = m_sitesInRegion.at(firstCentral + numCentral);
+              if (c.pos != m_posC + 1 + numCentral || c.count != centralCount)
+                break;
+              numCentral++;
+            }
+          numSlides = numCentral;
+        }
+      else if (firstCentral < size) // no sites reach the centre until this one
+        numSlides = min(numSlides, static_cast<long>(m_sitesInRegion.at(firstCentral).pos - m_posC - 1));
+
+      m_sitesInRegion.popLeft(numSlides);
+      for (long i = 0; i < numSlides; i++)
+        {
+          sd.pos = static_cast<int>(pos + i);
+          m_sitesInRegion.pushRight(sd);
+        }
+      s.begPos = pos - 1;
+      s.endPos = pos - 1 + numSlides;
+      sm.addSite(s);
+      m_sitesInRegion.advanceCentre(firstCentral - leftSize + (numCentral ? numSlides - 1 : 0));
+      m_posL += numSlides;
+      m_posC += numSlides;
+      m_posR += numSlides;
+      bool needToComputePMFs(false);
+      assignPvalueToCentralSite(sm, needToComputePMFs, numSlides);
+      pos += numSlides;
+    }
+}
+
+// Sites are passed to this class in genomic order, one input line at a time.
+// It hands them to its background region manager and site manager,
+// starting a new background region at each change of chromosome
+// and at each gap in the data that's wider than half the background window.
+// Once the window is sliding, contiguous lines with the same count (e.g., one line per bp of a run)
+// are collected into one pending run, which is handed over in one call when a line doesn't extend it.
+// With --stats, it also times each chromosome, from its first range of input through its last P-value.
+class SiteFeeder {
+public:
+  SiteFeeder(const int& windowSize, const NullModelSettings& nullModel,
+	     ostream& os, ScoreHistogram& hist, const ChromosomeTable& chroms, const bool& binaryOutput);
+  ~SiteFeeder(void);
+  void processRange(string* chrom, const long& start, const long& end, const int& count);
+  void endChromosome(void) { flushPendingRun(); m_brm.computePandFlush(m_sm); }; // optional; the next range begins a new chromosome
+  void finish(void);
+  void disableTiming(void) { m_pRunStatsTotal = NULL; }; // for a caller that times the chromosomes itself
+
+private:
+  SiteFeeder(void); // require use of the constructor with 6 arguments
+  SiteFeeder(const SiteFeeder&); // ditto
+  void startTiming(const string* chrom);
+  void flushPendingRun(void);
+  BackgroundRegionManager m_brm;
+  SiteManager m_sm;
+  SiteRange m_curSite;
+  SiteRange m_prevSite;
+  SiteRange m_pendingRun; // sites m_pendingRun.begPos+1 through m_pendingRun.endPos, not yet handed over
+  int m_windowSize;
+  int m_halfWindowSize;
+  RunStats m_runStats; // times only; counts are kept by m_brm
+  RunStats* m_pRunStatsTotal; // receives m_runStats upon destruction
+  const string* m_timedChrom; // the chromosome being timed, if any
+  double m_timedChromStart;
+  long m_numSitesOnTimedChrom;
+};
+
+SiteFeeder::SiteFeeder(const int& windowSize, const NullModelSettings& nullModel,
+		       ostream& os, ScoreHistogram& hist, const ChromosomeTable& chroms, const bool& binaryOutput)
+  : m_brm(nullModel), m_sm(os, hist, chroms, windowSize, binaryOutput)
+{
+  m_windowSize = windowSize;
+  m_halfWindowSize = windowSize / 2; // integer division
+  m_prevSite.chrom = NULL;
+  m_prevSite.endPos = -1;
+  m_pendingRun.chrom = NULL;
+  m_pendingRun.begPos = m_pendingRun.endPos = 0;
+  m_curSite.ID = NULL;
+  m_curSite.hasPval = false;
+  m_curSite.pval = -1.;
+#ifdef DEBUG
+  m_curSite.sampled = false;
+#endif
+  m_pRunStatsTotal = nullModel.pRunStats;
+  m_timedChrom = NULL;
+  m_timedChromStart = 0.;
+  m_numSitesOnTimedChrom = 0;
+}
+
+SiteFeeder::~SiteFeeder(void)
+{
+  if (m_pRunStatsTotal)
+    m_pRunStatsTotal->merge(m_runStats);
+}
+
+// Charge the time since the previous call to the chromosome that was being timed, and start timing chrom.
+void SiteFeeder::startTiming(const string* chrom)
+{
+  const double now(wallClockSeconds());
+  if (m_timedChrom)
+    m_runStats.addChromTime(m_timedChrom, m_numSitesOnTimedChrom, now - m_timedChromStart);
+  m_timedChrom = chrom;
+  m_timedChromStart = now;
+  m_numSitesOnTimedChrom = 0;
+}
+
+// Slide the background window over the pending run, if any.
+void SiteFeeder::flushPendingRun(void)
+{
+  if (m_pendingRun.endPos > m_pendingRun.begPos)
+    {
+      m_brm.slideRun(m_pendingRun, m_sm); // calls m_sm.addSite()
+      m_pendingRun.begPos = m_pendingRun.endPos;
+    }
+}
+
+void SiteFeeder::processRange(string* chrom, const long& start, const long& end, const int& count)
+{
+  const bool extendsPendingRun(m_pendingRun.endPos > m_pendingRun.begPos && chrom == m_pendingRun.chrom
+			       && start == m_pendingRun.endPos && count == m_pendingRun.count);
+  if (!extendsPendingRun)
+    flushPendingRun();
+  if (m_pRunStatsTotal)
+    {
+      if (chrom != m_timedChrom)
+        {
+          m_brm.computePandFlush(m_sm); // so that the previous chromosome's last P-values are charged to it; see below
+          startTiming(chrom);
+        }
+      if (end > start)
+        m_numSitesOnTimedChrom += end - start;
+    }
+  if (extendsPendingRun)
+    {
+      m_pendingRun.endPos = m_prevSite.endPos = end;
+      return;
+    }
+  m_curSite.chrom = chrom;
+  m_curSite.count = count;
+
+  // When contiguous stretches of sites with identical counts are observed
+  // within a line of input, they need to be processed one site at a time,
+  // for statistical reasons.
+  for (long siteEnd = start + 1; siteEnd <= end; siteEnd++)
+    {
+      m_curSite.endPos = siteEnd;
+      m_curSite.begPos = m_curSite.endPos - 1;
+
+      if (m_curSite.chrom != m_prevSite.chrom || m_curSite.endPos > m_prevSite.endPos + m_halfWindowSize)
+        {
+          m_brm.computePandFlush(m_sm); // Compute P-values for all unprocessed sites in the window.
+          // Writes values to disk.
+          // This method removes all count data from m_brm.
+          m_brm.setBounds(m_curSite.chrom, m_curSite.endPos, m_curSite.endPos + m_windowSize - 1);
+        }
+
+      if (!m_brm.isSliding() && m_curSite.endPos < m_brm.getRightEdge())
+        {
+          m_brm.add(m_curSite);
+          m_sm.addSite(m_curSite);
+        }
+      else if (!m_brm.isSliding() || 0 == m_halfWindowSize)
+        m_brm.slideAndCompute(m_curSite, m_sm); // calls m_sm.addSite(m_curSite)
+      else
+        {
+          // The remaining sites in this range are contiguous, so none of them can begin a new background region.
+          // Hand them over together, along with any following lines that extend them,
+          // so stretches that leave the distribution unchanged can be slid over at once.
+          m_curSite.endPos = end;
+          m_pendingRun = m_curSite;
+          m_prevSite = m_curSite;
+          return;
+        }
+
+      m_prevSite = m_curSite;
+    }
+}
+
+void SiteFeeder::finish(void)
+{
+  flushPendingRun();
+  m_brm.computePandFlush(m_sm); // See explanatory comment above.
+  m_sm.writeLastUnreportedSite();
+  if (m_pRunStatsTotal)
+    startTiming(NULL);
+}
+
+// Pass every range from src, a RangeReader or NeighborhoodTallier, to the feeder.
+template <class RangeSource>
+bool feedRanges(RangeSource& src, ChromosomeTable& chroms, SiteFeeder& feeder)
+{
+  string* chrom(NULL);
+
+  while (src.next())
+    {
+      if (src.chromChanged())
+        chrom = chroms.intern(src.chromName());
+      feeder.processRange(chrom, src.start(), src.end(), src.count());
+    }
+  if (src.failed())
+    return false;
+
+  feeder.finish();
+
+  return true;
+}
+
+bool parseAndProcessInput(const bool& binaryInput, const int& windowSize, const NullModelSettings& nullModel,
+			  ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput);
+bool parseAndProcessInput(const bool& binaryInput, const int& windowSize, const NullModelSettings& nullModel,
+			  ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput)
+{
+  RangeReader reader(cin, binaryInput);
+  SiteFeeder feeder(windowSize, nullModel, os, hist, chroms, binaryOutput);
+
+  if (!reader.readHeader())
+    return false;
+  return feedRanges(reader, chroms, feeder);
+}
+
+bool openForRead(ifstream& ifs, const string& filename);
+bool openForRead(ifstream& ifs, const string& filename)
+{
+  ifs.open(filename.c_str());
+  if (!ifs)
+    {
+      cerr << "Error:  Unable to open file \"" << filename << "\" for read." << endl
+           << endl;
+      return false;
+    }
+  return true;
+}
+
+// Tally the cut counts around each center site, instead of reading tallies from the input.
+bool tallyAndProcessInput(const string& centerSitesFilename, const string& cutcountsFilename, const int& neighborhoodSize,
+			  const int& windowSize, const NullModelSettings& nullModel,
+			  ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput);
+bool tallyAndProcessInput(const string& centerSitesFilename, const string& cutcountsFilename, const int& neighborhoodSize,
+			  const int& windowSize, const NullModelSettings& nullModel,
+			  ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput)
+{
+  ifstream ifsCenters, ifsCuts;
+  if (!openForRead(ifsCenters, centerSitesFilename) || !openForRead(ifsCuts, cutcountsFilename))
+    return false;
+  NeighborhoodTallier tallier(ifsCenters, ifsCuts, neighborhoodSize);
+  SiteFeeder feeder(windowSize, nullModel, os, hist, chroms, binaryOutput);
+
+  return feedRanges(tallier, chroms, feeder);
+}
+
+// A contiguous stretch of input ranges that can be processed independently of all others,
+// because the background window gets flushed at its start (a chromosome, or a chunk of one).
+// Its output is written to a temporary file (or, with --checkpoint, a file in the checkpoint directory);
+// these get concatenated in input order.
+struct InputSegment {
+  string* chrom;
+  streamoff offset; // byte offset of the segment's first range within the input file
+  streamoff numBytes;
+  RangeReader::Position pos; // reader state needed to resume reading at offset
+  string outfilename;
+  string histFilename; // with --checkpoint, where the segment's histogram of scores is kept; empty otherwise
+  string markerFilename; // with --checkpoint, written once the segment's output and histogram are complete
+  bool succeeded;
+};
+
+// With --checkpoint=DIR, the segments' outputs are kept in DIR instead of in temporary files, along with a record
+// of the run's progress, so that a run that gets interrupted (e.g., on a preempted node) can be resumed with --resume:
+//   index     the run's description (below) and its segments, in input order, with where each one begins in the input
+//   N.out     the output of segment N (numbered from 1, in input order)
+//   N.pvals   its histogram of scaled -log10(P) values, in the format of the file written by -p
+//   N.done    written once both of the above are complete:  the segment's chromosome and the size of N.out
+// A resumed run takes the segments, and the chromosome names (in the same order), from the index
+// instead of reading through the input, skips the segments that are done, and seeks in the input to each of the others.
+// The outputs are concatenated in input order as usual, so the output is identical to that of an uninterrupted run.
+// Input that can't be indexed and sought in (a pipe, stdin, or cut counts tallied around center sites)
+// is instead read once, in order, with each chromosome a segment; see feedRangesWithCheckpoint().
+// Whether such input has changed can only be checked for regular files; for pipes and stdin,
+// the caller must identify the input (inputId, e.g., the files it's decompressed from), or it's never resumed.
+// The files are removed once the run's output has been written (see removeCheckpoint()).
+struct CheckpointSettings {
+  CheckpointSettings(void) : resume(false) {};
+  string dir; // empty:  no checkpointing
+  bool resume;
+  string runDescription; // the options that determine the output; the checkpoint of a run with others isn't resumed
+  string inputId; // identifies input that isn't a regular file (--input-id); empty:  unidentified
+};
+
+bool InputSegment_numBytesGT(const InputSegment* a, const InputSegment* b);
+bool InputSegment_numBytesGT(const InputSegment* a, const InputSegment* b)
+{
+  return a->numBytes > b->numBytes;
+}
+
+// Read through the input file once, recording where each chromosome begins and ends.
+// Chromosome names are interned in order of first appearance, exactly as in a serial run.
+//
+// If chunkSize > 0, a chromosome is further split into chunks of at least chunkSize bp.
+// Chunks are only cut at gaps in the data wider than half the background window.
+// The background window is flushed at every such gap (see SiteFeeder::processRange()),
+// so no state carries across the cut, and a chunk needs no "halo" of neighboring data:
+// its P-values are exactly those of a serial run.  (A cut elsewhere would not reproduce them,
+// because the cutoff, mode, and sampling positions depend on the window's history.)
+// The sites on either side of such a gap are never adjacent,
+// so SiteManager never merges output ranges across the cut, either.
+bool indexInput(const string& infilename, const bool& binaryInput, const int& windowSize, const long& chunkSize,
+		ChromosomeTable& chroms, vector<InputSegment>& segments);
+bool indexInput(const string& infilename, const bool& binaryInput, const int& windowSize, const long& chunkSize,
+		ChromosomeTable& chroms, vector<InputSegment>& segments)
+{
+  long prevEnd(-1), segStart(0);
+  const int halfWindowSize(windowSize / 2); // integer division
+  streamoff endOfPrevRange(0); // not necessarily the start of the next range; in binary input, a block header can intervene
+  InputSegment seg;
+
+  ifstream ifs(infilename.c_str(), ios::binary);
+  if (!ifs)
+    {
+      cerr << "Error: Couldn't open input file " << infilename << endl;
+      return false;
+    }
+  RangeReader reader(ifs, binaryInput);
+  if (!reader.readHeader())
+    return false;
+
+  seg.succeeded = false;
+  while (reader.next())
+    {
+      const long start(reader.start()), end(reader.end());
+      bool startNewSegment(false);
+      if (reader.chromChanged())
+        {
+          seg.chrom = chroms.intern(reader.chromName());
+          startNewSegment = true;
+          prevEnd = -1;
+        }
+      else if (chunkSize > 0 && start < end && start + 1 > prevEnd + halfWindowSize && start - segStart >= chunkSize)
+        startNewSegment = true;
+      if (startNewSegment)
+        {
+          if (!segments.empty())
+            segments.back().numBytes = endOfPrevRange - segments.back().offset;
+          seg.offset = reader.offsetOfRange();
+          seg.pos = reader.positionOfRange();
+          seg.pos.chromName = *seg.chrom;
+          segments.push_back(seg);
+          segStart = start;
+        }
+      if (start < end)
+        prevEnd = end;
+      endOfPrevRange = reader.numBytesRead();
+    }
+  if (reader.failed())
+    return false;
+  if (!segments.empty())
+    segments.back().numBytes = endOfPrevRange - segments.back().offset;
+
+  return true;
+}
+
+bool createTempFile(string& filename);
+bool createTempFile(string& filename)
+{
+  const char* tmpdir = getenv("TMPDIR");
+  filename = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+  filename += "/hotspot2.XXXXXX";
+  vector<char> name(filename.begin(), filename.end());
+  name.push_back('\0');
+  int fd = mkstemp(&name[0]);
+  if (-1 == fd)
+    {
+      cerr << "Error:  Unable to create a temporary file \"" << filename << "\"." << endl
+           << endl;
+      return false;
+    }
+  close(fd);
+  filename = &name[0];
+  return true;
+}
+
+string checkpointFilename(const string& dir, const unsigned long& segmentNum, const string& suffix);
+string checkpointFilename(const string& dir, const unsigned long& segmentNum, const string& suffix)
+{
+  ostringstream oss;
+  oss << dir << '/' << segmentNum << suffix;
+  return oss.str();
+}
+
+bool isRegularFile(const string& filename);
+bool isRegularFile(const string& filename)
+{
+  struct stat st;
+  return stat(filename.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// The input file's name, size and modification time, which a checkpoint's input must match.
+bool describeInput(const string& infilename, string& description);
+bool describeInput(const string& infilename, string& description)
+{
+  struct stat st;
+  if (stat(infilename.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      cerr << "Error:  --checkpoint requires the input file " << infilename << " to be a regular file." << endl
+           << endl;
+      return false;
+    }
+  ostringstream oss;
+  oss << infilename << '\t' << static_cast<long>(st.st_size) << '\t' << static_cast<long>(st.st_mtime);
+  description = oss.str();
+  return true;
+}
+
+// Likewise for input that's read once, in order (see feedRangesWithCheckpoint()), which needn't be a file.
+// Returns false if it isn't a regular one (e.g., it's a pipe or stdin), which can't be checked;
+// its name (e.g., /dev/fd/63) says nothing about its contents, so it's described only as a stream.
+bool describeStreamedInput(const string& infilename, string& description);
+bool describeStreamedInput(const string& infilename, string& description)
+{
+  if (infilename.empty() || "-" == infilename || !isRegularFile(infilename))
+    {
+      description = "(stream)";
+      return false;
+    }
+  return describeInput(infilename, description);
+}
+
+bool writeCheckpointIndex(const CheckpointSettings& checkpoint, const string& inputDescription, const vector<InputSegment>& segments);
+bool writeCheckpointIndex(const CheckpointSettings& checkpoint, const string& inputDescription, const vector<InputSegment>& segments)
+{
+  // Written under another name and then renamed, so that an index is either complete or absent.
+  const string filename(checkpoint.dir + "/index"), tmpFilename(filename + ".tmp");
+  ofstream ofs(tmpFilename.c_str());
+  ofs << "hotspot2_part1 checkpoint\n"
+      << "options:  " << checkpoint.runDescription << '\n'
+      << "input:  " << inputDescription << '\n'
+      << "segments:  " << segments.size() << '\n';
+  for (vector<InputSegment>::const_iterator it = segments.begin(); it != segments.end(); it++)
+    ofs << *it->chrom << '\t' << it->offset << '\t' << it->numBytes << '\t' << it->pos.prevEnd
+        << '\t' << it->pos.linenum << '\t' << it->pos.numRecordsLeftInBlock << '\n';
+  ofs.close();
+  if (!ofs || rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+      cerr << "Error:  Unable to write the checkpoint index \"" << filename << "\"." << endl
+           << endl;
+      return false;
+    }
+  return true;
+}
+
+// Returns true if the checkpoint's index was written by a run of the same options on the same input,
+// in which case its segments and their chromosomes (interned in the same order as by indexInput()) are loaded.
+bool readCheckpointIndex(const CheckpointSettings& checkpoint, const string& inputDescription,
+                         ChromosomeTable& chroms, vector<InputSegment>& segments);
+bool readCheckpointIndex(const CheckpointSettings& checkpoint, const string& inputDescription,
+                         ChromosomeTable& chroms, vector<InputSegment>& segments)
+{
+  ifstream ifs((checkpoint.dir + "/index").c_str());
+  string line;
+  unsigned long numSegments(0);
+  if (!getline(ifs, line) || line != "hotspot2_part1 checkpoint")
+    return false;
+  if (!getline(ifs, line) || line != "options:  " + checkpoint.runDescription
+      || !getline(ifs, line) || line != "input:  " + inputDescription
+      || !getline(ifs, line) || line.compare(0, 11, "segments:  ") != 0)
+    {
+      cerr << "Warning:  The checkpoint in " << checkpoint.dir << " is from a run with other options or input;"
+           << " starting over." << endl;
+      return false;
+    }
+  numSegments = strtoul(line.c_str() + 11, NULL, 10);
+
+  // Only intern the chromosome names once the whole index has been read.
+  vector<string> chromNames(numSegments);
+  vector<InputSegment> loaded(numSegments);
+  for (unsigned long i = 0; i < numSegments; i++)
+    {
+      InputSegment& seg = loaded[i];
+      if (!getline(ifs, line))
+        return false;
+      istringstream iss(line);
+      if (!getline(iss, chromNames[i], '\t')
+          || !(iss >> seg.offset >> seg.numBytes >> seg.pos.prevEnd >> seg.pos.linenum >> seg.pos.numRecordsLeftInBlock))
+        return false;
+    }
+  for (unsigned long i = 0; i < numSegments; i++)
+    {
+      loaded[i].chrom = chroms.intern(chromNames[i]);
+      loaded[i].pos.chromName = chromNames[i];
+    }
+  segments.swap(loaded);
+  return true;
+}
+
+// Index the input, or with --resume, take the index from the checkpoint, if there's one for this run,
+// and give each segment its files in the checkpoint directory.
+bool prepareCheckpoint(const string& infilename, const bool& binaryInput, const int& windowSize, const long& chunkSize,
+                       const CheckpointSettings& checkpoint, ChromosomeTable& chroms, vector<InputSegment>& segments,
+                       bool& resumed);
+bool prepareCheckpoint(const string& infilename, const bool& binaryInput, const int& windowSize, const long& chunkSize,
+                       const CheckpointSettings& checkpoint, ChromosomeTable& chroms, vector<InputSegment>& segments,
+                       bool& resumed)
+{
+  string inputDescription;
+  if (!describeInput(infilename, inputDescription))
+    return false;
+  if (mkdir(checkpoint.dir.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+      cerr << "Error:  Unable to create the checkpoint directory \"" << checkpoint.dir << "\"." << endl
+           << endl;
+      return false;
+    }
+
+  resumed = checkpoint.resume && readCheckpointIndex(checkpoint, inputDescription, chroms, segments);
+  if (!resumed && !indexInput(infilename, binaryInput, windowSize, chunkSize, chroms, segments))
+    return false;
+  for (unsigned long i = 0; i < segments.size(); i++)
+    {
+      segments[i].outfilename = checkpointFilename(checkpoint.dir, i + 1, ".out");
+      segments[i].histFilename = checkpointFilename(checkpoint.dir, i + 1, ".pvals");
+      segments[i].markerFilename = checkpointFilename(checkpoint.dir, i + 1, ".done");
+      segments[i].succeeded = false;
+      if (!resumed)
+        remove(segments[i].markerFilename.c_str()); // left by an earlier run, whose index is about to be replaced
+    }
+  if (!resumed && !writeCheckpointIndex(checkpoint, inputDescription, segments))
+    return false;
+
+  return true;
+}
+
+// Whether an earlier run completed segment seg; if so, its histogram is added to hist.
+bool segmentIsDone(const InputSegment& seg, ScoreHistogram& hist);
+bool segmentIsDone(const InputSegment& seg, ScoreHistogram& hist)
+{
+  ifstream ifsMarker(seg.markerFilename.c_str());
+  string chrom;
+  streamoff outputSize(-1);
+  if (!getline(ifsMarker, chrom, '\t') || !(ifsMarker >> outputSize) || chrom != *seg.chrom)
+    return false;
+  ifstream ifsOutput(seg.outfilename.c_str(), ios::binary | ios::ate);
+  if (!ifsOutput || ifsOutput.tellg() != outputSize)
+    return false;
+  ifstream ifsHist(seg.histFilename.c_str());
+  ScoreHistogram segHist;
+  if (!ifsHist || !segHist.read(ifsHist))
+    return false;
+  hist.merge(segHist);
+  return true;
+}
+
+// Close segment seg's output, then write its histogram, and then its marker.
+bool writeSegmentCheckpoint(const InputSegment& seg, ofstream& ofsOutput, const ScoreHistogram& hist);
+bool writeSegmentCheckpoint(const InputSegment& seg, ofstream& ofsOutput, const ScoreHistogram& hist)
+{
+  const streamoff outputSize(ofsOutput.tellp());
+  ofsOutput.close();
+  ofstream ofsHist(seg.histFilename.c_str());
+  hist.write(ofsHist);
+  ofsHist.close();
+  if (!ofsOutput || !ofsHist)
+    {
+      cerr << "Error:  Unable to write the checkpoint of chromosome " << *seg.chrom << " to \""
+           << seg.outfilename << "\" and \"" << seg.histFilename << "\"." << endl
+           << endl;
+      return false;
+    }
+  ofstream ofsMarker(seg.markerFilename.c_str());
+  ofsMarker << *seg.chrom << '\t' << outputSize << '\n';
+  ofsMarker.close();
+  if (!ofsMarker)
+    {
+      cerr << "Error:  Unable to write the checkpoint marker \"" << seg.markerFilename << "\"." << endl
+           << endl;
+      return false;
+    }
+  return true;
+}
+
+// Remove the files of a completed run's checkpoint (but not the directory).
+// A streamed run's index records no segments, so files are removed until the next segment has none.
+void removeCheckpoint(const string& dir);
+void removeCheckpoint(const string& dir)
+{
+  const string indexFilename(dir + "/index");
+  ifstream ifs(indexFilename.c_str());
+  string line;
+  unsigned long numSegments(0);
+  while (getline(ifs, line))
+    {
+      if (0 == line.compare(0, 11, "segments:  "))
+        {
+          numSegments = strtoul(line.c_str() + 11, NULL, 10);
+          break;
+        }
+    }
+  ifs.close();
+  for (unsigned long i = 1; ; i++)
+    {
+      const bool removedMarker(remove(checkpointFilename(dir, i, ".done").c_str()) == 0);
+      const bool removedHist(remove(checkpointFilename(dir, i, ".pvals").c_str()) == 0);
+      const bool removedOutput(remove(checkpointFilename(dir, i, ".out").c_str()) == 0);
+      if (i >= numSegments && !removedMarker && !removedHist && !removedOutput)
+        break;
+    }
+  remove(indexFilename.c_str());
+}
+
+// State shared by the worker threads.  Each thread repeatedly takes the largest remaining segment.
+struct SegmentQueue {
+  vector<InputSegment*> pending; // sorted in descending order of size
+  unsigned int idxNext;
+  pthread_mutex_t mutex;
+  string infilename;
+  bool binaryInput;
+  int windowSize;
+  NullModelSettings nullModel;
+  bool binaryOutput;
+  const ChromosomeTable* pChroms;
+  ScoreHistogram* pHist; // each segment's histogram gets merged into this one, under the mutex
+};
+
+bool processSegment(InputSegment& seg, SegmentQueue& q);
+bool processSegment(InputSegment& seg, SegmentQueue& q)
+{
+  ifstream ifs(q.infilename.c_str(), ios::binary);
+  ofstream ofs(seg.outfilename.c_str(), ios::binary);
+  if (!ifs || !ofs)
+    {
+      cerr << "Error:  Unable to open the input file or temporary output file for chromosome "
+           << *seg.chrom << "." << endl
+           << endl;
+      return false;
+    }
+  ifs.seekg(seg.offset);
+  RangeReader reader(ifs, q.binaryInput);
+  reader.resume(seg.pos);
+
+  ScoreHistogram hist;
+  SiteFeeder feeder(q.windowSize, q.nullModel, ofs, hist, *q.pChroms, q.binaryOutput);
+
+  while (reader.numBytesRead() < seg.numBytes && reader.next())
+    {
+      if (reader.chromChanged())
+        {
+          cerr << "Error:  Expected chromosome " << *seg.chrom << " in range " << reader.linenum()
+               << ", found " << reader.chromName() << "; was the input file modified during this run?" << endl
+               << endl;
+          return false;
+        }
+      feeder.processRange(seg.chrom, reader.start(), reader.end(), reader.count());
+    }
+  if (reader.failed())
+    return false;
+
+  feeder.finish();
+  if (!seg.markerFilename.empty() && !writeSegmentCheckpoint(seg, ofs, hist))
+    return false;
+
+  pthread_mutex_lock(&q.mutex);
+  q.pHist->merge(hist);
+  pthread_mutex_unlock(&q.mutex);
+
+  return true;
+}
+
+void* processSegments(void* arg);
+void* processSegments(void* arg)
+{
+  SegmentQueue& q = *static_cast<SegmentQueue*>(arg);
+
+  for (;;)
+    {
+      InputSegment* pSeg(NULL);
+      pthread_mutex_lock(&q.mutex);
+      if (q.idxNext < q.pending.size())
+        pSeg = q.pending[q.idxNext++];
+      pthread_mutex_unlock(&q.mutex);
+      if (NULL == pSeg)
+        break;
+      pSeg->succeeded = processSegment(*pSeg, q);
+    }
+
+  return NULL;
+}
+
+// Copy the contents of a segment's output file to the stream.
+bool appendFile(const string& filename, ostream& os);
+bool appendFile(const string& filename, ostream& os)
+{
+  ifstream ifs(filename.c_str(), ios::binary);
+  if (!ifs)
+    {
+      cerr << "Error:  Unable to open file \"" << filename << "\" for read." << endl
+           << endl;
+      return false;
+    }
+  if (ifs.peek() != ifstream::traits_type::eof())
+    os << ifs.rdbuf();
+  return true;
+}
+
+// Each chromosome (or chunk of one; see indexInput()) gets its own background region manager
+// and site manager, on one of numThreads threads.  The largest segments are processed first.  Results are concatenated in input order,
+// so the output is identical to that of a serial run.  With a checkpoint directory (see CheckpointSettings),
+// the segments that a previous run completed are skipped when resuming, and the ones left unfinished upon failure
+// are kept for the next attempt.
+bool parseAndProcessInputInParallel(const string& infilename, const bool& binaryInput, const int& numThreads, const long& chunkSize,
+				    const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+				    ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput);
+bool parseAndProcessInputInParallel(const string& infilename, const bool& binaryInput, const int& numThreads, const long& chunkSize,
+				    const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+				    ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput)
+{
+  vector<InputSegment> segments;
+  const bool checkpointing(!checkpoint.dir.empty());
+  bool resumed(false);
+  if (checkpointing)
+    {
+      if (!prepareCheckpoint(infilename, binaryInput, windowSize, chunkSize, checkpoint, chroms, segments, resumed))
+        return false;
+    }
+  else if (!indexInput(infilename, binaryInput, windowSize, chunkSize, chroms, segments))
+    return false;
+
+  SegmentQueue q;
+  q.infilename = infilename;
+  q.binaryInput = binaryInput;
+  q.windowSize = windowSize;
+  q.nullModel = nullModel;
+  q.binaryOutput = binaryOutput;
+  q.pChroms = &chroms;
+  q.pHist = &hist;
+  q.idxNext = 0;
+  pthread_mutex_init(&q.mutex, NULL);
+
+  bool ok(true);
+  for (vector<InputSegment>::iterator it = segments.begin(); it != segments.end(); it++)
+    {
+      if (resumed && segmentIsDone(*it, hist))
+        {
+          it->succeeded = true;
+          continue;
+        }
+      if (ok && !checkpointing && !createTempFile(it->outfilename))
+        ok = false;
+      q.pending.push_back(&(*it));
+    }
+  stable_sort(q.pending.begin(), q.pending.end(), InputSegment_numBytesGT);
+
+  if (ok)
+    {
+      vector<pthread_t> threads(min(numThreads, static_cast<int>(q.pending.size())));
+      for (unsigned int i = 0; i < threads.size(); i++)
+        {
+          if (pthread_create(&threads[i], NULL, processSegments, &q) != 0)
+            {
+              cerr << "Error:  Unable to create thread " << i + 1 << "." << endl
+                   << endl;
+              exit(1);
+            }
+        }
+      for (unsigned int i = 0; i < threads.size(); i++)
+        pthread_join(threads[i], NULL);
+    }
+  pthread_mutex_destroy(&q.mutex);
+
+  for (vector<InputSegment>::iterator it = segments.begin(); it != segments.end(); it++)
+    {
+      if (ok && !it->succeeded)
+        ok = false;
+      if (ok)
+        {
+          if (!appendFile(it->outfilename, os))
+            ok = false;
+          else if (!checkpointing)
+            remove(it->outfilename.c_str());
+        }
+      else
+        {
+          if (!checkpointing && !it->outfilename.empty())
+            remove(it->outfilename.c_str());
+        }
+    }
+
+  return ok;
+}
+
+// Like feedRanges(), with a checkpoint (see CheckpointSettings) of input that can't be indexed and sought in.
+// It's read once, in order, and each chromosome is a segment, processed as it's read by a site feeder of its own
+// (as in parseAndProcessInputInParallel(), so the output is identical to that of feedRanges()).
+// When resuming, the chromosomes that an earlier run completed are read through without being processed,
+// and their output and histogram are taken from the checkpoint.  The number of segments isn't known in advance,
+// so the index records none; its description of the run says that it was streamed, so that the checkpoint
+// of an indexed run, whose segments can be chunks of chromosomes, isn't mistaken for this one's, or vice versa.
+// If any of the input isn't a regular file (inputChecked == false), checkpoint.inputId must identify it;
+// it's recorded with the input's description, and a checkpoint without a match isn't resumed.
+template <class RangeSource>
+bool feedRangesWithCheckpoint(RangeSource& src, const string& inputDescription, const bool& inputChecked,
+			      const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+			      ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput)
+{
+  CheckpointSettings streamed(checkpoint);
+  streamed.runDescription += " (streamed)";
+  string description(inputDescription);
+  if (!streamed.inputId.empty())
+    description += "\t--input-id " + streamed.inputId;
+  else if (!inputChecked && streamed.resume)
+    {
+      cerr << "Warning:  The input isn't a regular file, and --input-id wasn't given, so it can't be checked against\n"
+           << "the checkpoint in " << streamed.dir << "; starting over." << endl;
+      streamed.resume = false;
+    }
+  if (mkdir(streamed.dir.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+      cerr << "Error:  Unable to create the checkpoint directory \"" << streamed.dir << "\"." << endl
+           << endl;
+      return false;
+    }
+  vector<InputSegment> noSegments;
+  const bool resumed(streamed.resume && readCheckpointIndex(streamed, description, chroms, noSegments));
+  if (!resumed)
+    {
+      removeCheckpoint(streamed.dir); // files left by an earlier run could otherwise be taken as this one's
+      if (!writeCheckpointIndex(streamed, description, noSegments))
+        return false;
+    }
+
+  unsigned long segmentNum(0);
+  bool more(src.next());
+  while (more)
+    {
+      // src holds the first range of the next chromosome.
+      InputSegment seg;
+      seg.chrom = chroms.intern(src.chromName());
+      segmentNum++;
+      seg.outfilename = checkpointFilename(streamed.dir, segmentNum, ".out");
+      seg.histFilename = checkpointFilename(streamed.dir, segmentNum, ".pvals");
+      seg.markerFilename = checkpointFilename(streamed.dir, segmentNum, ".done");
+      if (resumed && segmentIsDone(seg, hist))
+        {
+          while ((more = src.next()) && !src.chromChanged())
+            ;
+        }
+      else
+        {
+          remove(seg.markerFilename.c_str());
+          ofstream ofs(seg.outfilename.c_str(), ios::binary);
+          if (!ofs)
+            {
+              cerr << "Error:  Unable to open file \"" << seg.outfilename << "\" for write." << endl
+                   << endl;
+              return false;
+            }
+          ScoreHistogram segHist;
+          {
+            SiteFeeder feeder(windowSize, nullModel, ofs, segHist, chroms, binaryOutput);
+            do
+              feeder.processRange(seg.chrom, src.start(), src.end(), src.count());
+            while ((more = src.next()) && !src.chromChanged());
+            if (src.failed())
+              return false;
+            feeder.finish();
+          }
+          if (!writeSegmentCheckpoint(seg, ofs, segHist))
+            return false;
+          hist.merge(segHist);
+        }
+      if (src.failed() || !appendFile(seg.outfilename, os))
+        return false;
+    }
+
+  return !src.failed();
+}
+
+// parseAndProcessInput() with a checkpoint, for input from stdin or a file that isn't regular, such as a pipe.
+bool parseAndProcessInputWithCheckpoint(const string& infilename, const bool& binaryInput,
+					const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+					ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput);
+bool parseAndProcessInputWithCheckpoint(const string& infilename, const bool& binaryInput,
+					const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+					ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput)
+{
+  const bool fromStdin(infilename.empty() || "-" == infilename);
+  ifstream ifs;
+  if (!fromStdin && !openForRead(ifs, infilename))
+    return false;
+  RangeReader reader(fromStdin ? cin : ifs, binaryInput);
+
+  if (!reader.readHeader())
+    return false;
+  string inputDescription;
+  const bool inputChecked(describeStreamedInput(infilename, inputDescription));
+  return feedRangesWithCheckpoint(reader, inputDescription, inputChecked,
+				  windowSize, nullModel, checkpoint, chroms, os, hist, binaryOutput);
+}
+
+// tallyAndProcessInput() with a checkpoint.
+bool tallyAndProcessInputWithCheckpoint(const string& centerSitesFilename, const string& cutcountsFilename, const int& neighborhoodSize,
+					const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+					ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput);
+bool tallyAndProcessInputWithCheckpoint(const string& centerSitesFilename, const string& cutcountsFilename, const int& neighborhoodSize,
+					const int& windowSize, const NullModelSettings& nullModel, const CheckpointSettings& checkpoint,
+					ChromosomeTable& chroms, ostream& os, ScoreHistogram& hist, const bool& binaryOutput)
+{
+  ifstream ifsCenters, ifsCuts;
+  if (!openForRead(ifsCenters, centerSitesFilename) || !openForRead(ifsCuts, cutcountsFilename))
+    return false;
+  NeighborhoodTallier tallier(ifsCenters, ifsCuts, neighborhoodSize);
+  string centersDescription, cutsDescription;
+  const bool centersChecked(describeStreamedInput(centerSitesFilename, centersDescription));
+  const bool cutsChecked(describeStreamedInput(cutcountsFilename, cutsDescription));
+  ostringstream inputDescription;
+  inputDescription << centersDescription << '\t' << cutsDescription << "\t-N " << neighborhoodSize;
+
+  return feedRangesWithCheckpoint(tallier, inputDescription.str(), centersChecked && cutsChecked,
+				  windowSize, nullModel, checkpoint, chroms, os, hist, binaryOutput);
+}
+
+// Several samples with counts at the same sites (see MultiSampleReader) are processed in one pass.
+// Each sample gets its own site feeder, output stream and histogram, so its output is that of a separate run,
+// but the input is parsed once.  It's read in blocks of ranges, each on one chromosome,
+// and with numThreads > 1, each thread feeds the whole block to its share of the samples
+// while the others do the same.  With --stats, the counts are totals over the samples,
+// and each chromosome's sites are counted once per sample.
+const unsigned long SAMPLE_BLOCK_SIZE = 16384; // ranges
+
+struct SampleWork {
+  vector<SiteFeeder*> feeders;
+  int numThreads;
+  string* chrom;
+  vector<long> starts;
+  vector<long> ends;
+  vector<int> counts; // sample k's count in range i is counts[k*SAMPLE_BLOCK_SIZE + i]
+  unsigned long numRanges;
+  bool endsChrom; // the next block (if any) is on another chromosome
+  bool finish; // no more blocks; finish the samples after this one
+  bool done; // the threads exit after this block
+  pthread_barrier_t blockReady;
+  pthread_barrier_t blockFed;
+};
+
+struct SampleThread {
+  SampleWork* pWork;
+  int idx;
+};
+
+void feedBlock(SampleWork& w, const int& thread);
+void feedBlock(SampleWork& w, const int& thread)
+{
+  for (unsigned int k = thread; k < w.feeders.size(); k += w.numThreads)
+    {
+      SiteFeeder& feeder = *w.feeders[k];
+      const int* counts = &w.counts[k * SAMPLE_BLOCK_SIZE];
+      for (unsigned long i = 0; i < w.numRanges; i++)
+        feeder.processRange(w.chrom, w.starts[i], w.ends[i], counts[i]);
+      if (w.endsChrom)
+        feeder.endChromosome();
+      if (w.finish)
+        feeder.finish();
+    }
+}
+
+void* feedSamples(void* arg);
+void* feedSamples(void* arg)
+{
+  SampleThread& t = *static_cast<SampleThread*>(arg);
+  SampleWork& w = *t.pWork;
+
+  for (;;)
+    {
+      pthread_barrier_wait(&w.blockReady);
+      feedBlock(w, t.idx);
+      const bool done(w.done); // once past blockFed, the calling thread may be filling in the next block
+      pthread_barrier_wait(&w.blockFed);
+      if (done)
+        break;
+    }
+
+  return NULL;
+}
+
+bool processSamples(MultiSampleReader& reader, const int& numThreads, const int& windowSize, const NullModelSettings& nullModel,
+		    ChromosomeTable& chroms, const vector<ostream*>& outputs, const vector<ScoreHistogram*>& hists, const bool& binaryOutput);
+bool processSamples(MultiSampleReader& reader, const int& numThreads, const int& windowSize, const NullModelSettings& nullModel,
+		    ChromosomeTable& chroms, const vector<ostream*>& outputs, const vector<ScoreHistogram*>& hists, const bool& binaryOutput)
+{
+  const int numSamples(reader.numSamples());
+  SampleWork w;
+  w.numThreads = min(numThreads, numSamples);
+  for (int k = 0; k < numSamples; k++)
+    {
+      w.feeders.push_back(new SiteFeeder(windowSize, nullModel, *outputs[k], *hists[k], chroms, binaryOutput));
+      w.feeders.back()->disableTiming(); // a sample's chromosome would include the time spent on the others
+    }
+  w.starts.resize(SAMPLE_BLOCK_SIZE);
+  w.ends.resize(SAMPLE_BLOCK_SIZE);
+  w.counts.resize(SAMPLE_BLOCK_SIZE * numSamples);
+  w.chrom = NULL;
+  w.numRanges = 0;
+  w.endsChrom = w.finish = w.done = false;
+  pthread_barrier_init(&w.blockReady, NULL, w.numThreads);
+  pthread_barrier_init(&w.blockFed, NULL, w.numThreads);
+
+  vector<SampleThread> threadArgs(w.numThreads);
+  vector<pthread_t> threads(w.numThreads);
+  for (int i = 1; i < w.numThreads; i++) // the calling thread is thread 0
+    {
+      threadArgs[i].pWork = &w;
+      threadArgs[i].idx = i;
+      if (pthread_create(&threads[i], NULL, feedSamples, &threadArgs[i]) != 0)
+        {
+          cerr << "Error:  Unable to create thread " << i + 1 << "." << endl
+               << endl;
+          exit(1);
+        }
+    }
+
+  RunStats times; // times only; the feeders' background region managers keep the counts
+  double blockStart(wallClockSeconds());
+  bool haveRange(reader.next());
+  while (haveRange)
+    {
+      if (reader.chromChanged())
+        w.chrom = chroms.intern(reader.chromName());
+      long numSites(0);
+      w.numRanges = 0;
+      do
+        {
+          const unsigned long i(w.numRanges++);
+          w.starts[i] = reader.start();
+          w.ends[i] = reader.end();
+          for (int k = 0; k < numSamples; k++)
+            w.counts[k * SAMPLE_BLOCK_SIZE + i] = reader.count(k);
+          if (reader.end() > reader.start())
+            numSites += reader.end() - reader.start();
+          haveRange = reader.next();
+        }
+      while (haveRange && !reader.chromChanged() && w.numRanges < SAMPLE_BLOCK_SIZE);
+      w.endsChrom = haveRange && reader.chromChanged();
+      w.finish = w.done = !haveRange && !reader.failed();
+
+      pthread_barrier_wait(&w.blockReady);
+      feedBlock(w, 0);
+      pthread_barrier_wait(&w.blockFed);
+      if (nullModel.pRunStats)
+        {
+          const double now(wallClockSeconds());
+          times.addChromTime(w.chrom, numSites * numSamples, now - blockStart);
+          blockStart = now;
+        }
+    }
+  if (!w.done)
+    {
+      // Empty input, or an error (in which case the samples are left unfinished); release the threads.
+      w.numRanges = 0;
+      w.endsChrom = false;
+      w.finish = !reader.failed();
+      w.done = true;
+      pthread_barrier_wait(&w.blockReady);
+      feedBlock(w, 0);
+      pthread_barrier_wait(&w.blockFed);
+    }
+  for (int i = 1; i < w.numThreads; i++)
+    pthread_join(threads[i], NULL);
+  pthread_barrier_destroy(&w.blockReady);
+  pthread_barrier_destroy(&w.blockFed);
+  for (vector<SiteFeeder*>::iterator it = w.feeders.begin(); it != w.feeders.end(); it++)
+    delete *it;
+
+  if (reader.failed())
+    return false;
+  if (nullModel.pRunStats)
+    nullModel.pRunStats->merge(times);
+
+  return true;
+}
+
+// Read several samples from one file (or stdin, if infilenames is empty) with a count per sample in fields 5, 6, ...,
+// or from one BED5 file per sample.
+bool parseAndProcessSamples(const vector<string>& infilenames, const int& numSamples, const int& numThreads,
+			    const int& windowSize, const NullModelSettings& nullModel,
+			    ChromosomeTable& chroms, const vector<ostream*>& outputs, const vector<ScoreHistogram*>& hists, const bool& binaryOutput);
+bool parseAndProcessSamples(const vector<string>& infilenames, const int& numSamples, const int& numThreads,
+			    const int& windowSize, const NullModelSettings& nullModel,
+			    ChromosomeTable& chroms, const vector<ostream*>& outputs, const vector<ScoreHistogram*>& hists, const bool& binaryOutput)
+{
+  vector<ifstream*> files;
+  bool ok(true);
+  for (vector<string>::const_iterator it = infilenames.begin(); it != infilenames.end() && ok; it++)
+    {
+      files.push_back(new ifstream(it->c_str()));
+      if (!*files.back())
+        {
+          cerr << "Error:  Unable to open file \"" << *it << "\" for read." << endl
+               << endl;
+          ok = false;
+        }
+    }
+  if (ok && files.size() > 1)
+    {
+      MultiSampleReader reader(vector<istream*>(files.begin(), files.end()));
+      ok = processSamples(reader, numThreads, windowSize, nullModel, chroms, outputs, hists, binaryOutput);
+    }
+  else if (ok)
+    {
+      MultiSampleReader reader(files.empty() ? cin : *files[0], numSamples);
+      ok = processSamples(reader, numThreads, windowSize, nullModel, chroms, outputs, hists, binaryOutput);
+    }
+  for (vector<ifstream*>::iterator it = files.begin(); it != files.end(); it++)
+    delete *it;
+
+  return ok;
+}
+
+#endif // HOTSPOT2_PVALUES_H
@@ -0,0 +1,153 @@
+// Reading tab-separated text, as shared by all of the hotspot2 tools that read it:
+// the input is read in large blocks, lines and fields are located with memchr()
+// (which the C library implements with vector instructions), fields are null-terminated in place,
+// and integers are parsed directly from the buffer, so reading a line neither allocates nor copies.
+//
+#ifndef HOTSPOT2_TSV_H
+#define HOTSPOT2_TSV_H
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Delivers the lines of a stream one at a time, without their newlines, null-terminated.
+// A line remains valid, and may be modified in place (e.g., by splitFields()), until the next call to next().
+// Lines of any length are accepted; the buffer grows to hold the longest one.
+// Input is taken directly from the stream's buffer, so the stream itself shouldn't be read while this is in use.
+class LineReader {
+public:
+  LineReader(istream& is);
+  bool next(void); // returns false at the end of input
+  void reset(void); // discard anything buffered, e.g., after the caller has seeked the stream
+  char* line(void) { return m_line; };
+  const size_t& length(void) const { return m_length; };
+  const streamoff& numBytesRead(void) const { return m_numBytesRead; }; // bytes in the lines delivered so far, including newlines
+
+private:
+  LineReader(void); // require use of the constructor with 1 argument
+  LineReader(const LineReader&); // ditto
+  static const size_t BLOCKSIZE = 1 << 16;
+  istream& m_is;
+  vector<char> m_buf; // one byte beyond the data is always available, for terminating a final line that lacks a newline
+  size_t m_begin; // start of the data not yet delivered
+  size_t m_scanned; // m_begin through m_scanned - 1 are known to contain no newline
+  size_t m_end; // end of the data in m_buf
+  bool m_eof;
+  char* m_line;
+  size_t m_length;
+  streamoff m_numBytesRead;
+};
+
+LineReader::LineReader(istream& is) : m_is(is), m_buf(BLOCKSIZE + 1)
+{
+  reset();
+  m_numBytesRead = 0;
+}
+
+void LineReader::reset(void)
+{
+  m_begin = m_scanned = m_end = 0;
+  m_eof = false;
+  m_line = NULL;
+  m_length = 0;
+  m_numBytesRead = 0;
+}
+
+bool LineReader::next(void)
+{
+  for (;;)
+    {
+      char* nl = static_cast<char*>(memchr(&m_buf[m_scanned], '\n', m_end - m_scanned));
+      if (nl)
+        {
+          m_line = &m_buf[m_begin];
+          m_length = nl - m_line;
+          *nl = '\0';
+          m_begin = m_scanned = m_begin + m_length + 1;
+          m_numBytesRead += m_length + 1;
+          return true;
+        }
+      m_scanned = m_end;
+      if (m_eof)
+        {
+          if (m_begin == m_end)
+            return false;
+          // The final line lacks a newline.
+          m_line = &m_buf[m_begin];
+          m_length = m_end - m_begin;
+          m_buf[m_end] = '\0';
+          m_begin = m_scanned = m_end;
+          m_numBytesRead += m_length;
+          return true;
+        }
+      // Move the partial line to the front of the buffer, enlarging the buffer if the line fills it, and refill.
+      if (m_begin > 0)
+        {
+          memmove(&m_buf[0], &m_buf[m_begin], m_end - m_begin);
+          m_end -= m_begin;
+          m_scanned = m_end;
+          m_begin = 0;
+        }
+      if (m_end == m_buf.size() - 1)
+        m_buf.resize(2 * (m_buf.size() - 1) + 1);
+      const streamsize n = m_is.rdbuf()->sgetn(&m_buf[m_end], static_cast<streamsize>(m_buf.size() - 1 - m_end));
+      if (n <= 0)
+        m_eof = true;
+      else
+        m_end += static_cast<size_t>(n);
+    }
+}
+
+// Splits the null-terminated line at each occurrence of delim, replacing those delimiters with '\0',
+// and points fields[0] through fields[maxFields - 1] at the resulting fields.
+// Returns the number of fields found, except that it stops looking at maxFields + 1:
+// anything following field maxFields is left as is, so that callers can detect extra fields.
+// Unlike strtok(), empty fields count as fields.
+inline int splitFields(char* line, const size_t& length, const char& delim, char** fields, const int& maxFields)
+{
+  char* p = line;
+  char* const end = line + length;
+  int n(0);
+  while (n < maxFields)
+    {
+      fields[n++] = p;
+      char* q = static_cast<char*>(memchr(p, delim, end - p));
+      if (!q)
+        return n;
+      *q = '\0';
+      p = q + 1;
+    }
+  return n + 1; // there's at least one more field
+}
+
+// atol() and atoi() for the decimal integers in the input, without the C library's locale handling:
+// optional leading whitespace, an optional sign, then digits; parsing stops at the first non-digit.
+inline long parseLong(const char* p)
+{
+  while (' ' == *p || '\t' == *p)
+    p++;
+  bool negative(false);
+  if ('-' == *p || '+' == *p)
+    negative = ('-' == *p++);
+  long val(0);
+  for (unsigned int digit = static_cast<unsigned char>(*p) - '0'; digit < 10; digit = static_cast<unsigned char>(*++p) - '0')
+    val = 10 * val + static_cast<long>(digit);
+  return negative ? -val : val;
+}
+
+inline int parseInt(const char* p)
+{
+  return static_cast<int>(parseLong(p));
+}
+
+// Whether name (of the given length) equals s; the lengths are compared first,
+// so that a change of chromosome is usually detected without comparing any characters.
+inline bool sameName(const string& s, const char* name, const size_t& length)
+{
+  return s.size() == length && 0 == memcmp(s.data(), name, length);
+}
+
+#endif // HOTSPOT2_TSV_H
@@ -1,3 +1,4 @@
+#include "hotspot2_tsv.h"
 #include <iostream>
 #include <vector>
 #include <list>
@@ -72,37 +73,24 @@ void resolveOverlaps(list<Peak>& peaks)
 }
 
 // function to parse/extract the data for each peak
-// into a Peak data structure
-bool PeakfromString(char *s, Peak& d);
-bool PeakfromString(char *s, Peak& d)
+// into a Peak data structure; s, of the given length, gets split in place
+bool PeakfromString(char *s, const size_t& length, Peak& d);
+bool PeakfromString(char *s, const size_t& length, Peak& d)
 {
-  char *p = strtok(s, "\t");
-  int fieldnum(1);
-  if (!p)
+  char* fields[5];
+  const int numFields = splitFields(s, length, '\t', fields, 5);
+  if (numFields < 5)
     {
-    MissingField:
-      cerr << "Error:  Missing required field " << fieldnum
+      cerr << "Error:  Missing required field " << numFields + 1
 	   << " in " << s << "." << endl << endl;
       return false;
     }
-  d.chrom = string(p);
-  fieldnum++;
-  if (!(p = strtok(NULL, "\t")))
-    goto MissingField;
-  d.beg = atol(p);
-  fieldnum++;
-  if (!(p = strtok(NULL, "\t")))
-    goto MissingField;
-  d.end = atol(p);
-  fieldnum++;
-  if (!(p = strtok(NULL, "\t")))
-    goto MissingField;
-  d.id = string(p);
-  fieldnum++;
-  if (!(p = strtok(NULL, "\t")))
-    goto MissingField;
-  d.score = atof(p);
-  d.score_string = string(p);
+  d.chrom.assign(fields[0], fields[1] - fields[0] - 1);
+  d.beg = parseLong(fields[1]);
+  d.end = parseLong(fields[2]);
+  d.id = fields[3];
+  d.score = atof(fields[4]);
+  d.score_string = fields[4];
   return true;
 }
 
@@ -120,31 +108,41 @@ bool PeakfromString(char *s, Peak& d)
 bool parseInputWriteOutput(void);
 bool parseInputWriteOutput(void)
 {
-  const int BUFSIZE(500000);
-  char buf[BUFSIZE], *p;
+  LineReader lines(cin);
   long linenum(0);
 
-  while (cin.getline(buf, BUFSIZE))
+  while (lines.next())
     {
       list<Peak> Peaks;
-      vector<string> vec; // this vector is used for parsing/extracting Peak data
+      char* p = lines.line();
+      char* const end = p + lines.length();
       linenum++;
-      if (!(p = strtok(buf, "|")))
+      // The merged peak, which is ignored, runs up to the first "|" (after any leading ones).
+      while (p < end && '|' == *p)
+	p++;
+      if (p == end)
 	{
 	  cerr << "Error:  Failed to find |-delimited input on line " << linenum
 	       << " of the input file." << endl << endl;
 	  return false;
 	}
-      while ((p = strtok(NULL, ";")))
-	vec.push_back(string(p));
-      for (int i = 0; i < static_cast<int>(vec.size()); i++)
+      p = static_cast<char*>(memchr(p, '|', end - p));
+      p = p ? p + 1 : end;
+      // The peaks are separated by semicolons; empty entries are skipped.
+      while (p < end)
 	{
-	  Peak d;
-	  char s[1000];
-	  strcpy(s,vec[i].c_str());
-	  if (!PeakfromString(s, d))
-	    return false;
-	  Peaks.push_back(d);
+	  char* q = static_cast<char*>(memchr(p, ';', end - p));
+	  if (!q)
+	    q = end;
+	  *q = '\0';
+	  if (q != p)
+	    {
+	      Peak d;
+	      if (!PeakfromString(p, q - p, d))
+		return false;
+	      Peaks.push_back(d);
+	    }
+	  p = q + 1;
 	}
       resolveOverlaps(Peaks);
       for (list<Peak>::const_iterator it = Peaks.begin();